@@ -48,6 +48,12 @@ enum Annotation {
    * Is this a start function?
    */
   START = 64,
+
+  /**
+   * Is this a local variable that is assigned as a whole after its
+   * declaration, rather than only by element?
+   */
+  REASSIGNED = 128
 };
 
 /**
@@ -4,8 +4,26 @@
 #include "src/generate/CppGenerator.hpp"
 
 #include "src/generate/CppClassGenerator.hpp"
+#include "src/visitor/Gatherer.hpp"
 #include "src/primitive/encode.hpp"
 
+/**
+ * If an expression is a slice that selects a single element of a named
+ * array, get the array, otherwise null.
+ */
+static const birch::NamedExpression* element_of(const birch::Expression* o) {
+  auto slice = dynamic_cast<const birch::Slice*>(o);
+  if (slice) {
+    for (auto bracket : *slice->brackets) {
+      if (dynamic_cast<const birch::Range*>(bracket)) {
+        return nullptr;
+      }
+    }
+    return dynamic_cast<const birch::NamedExpression*>(slice->single);
+  }
+  return nullptr;
+}
+
 birch::CppGenerator::CppGenerator(std::ostream& base, const int level,
     const bool header, const bool generic) :
     IndentableGenerator(base, level),
@@ -110,7 +128,12 @@ void birch::CppGenerator::visit(const UnaryCall* o) {
 void birch::CppGenerator::visit(const Assign* o) {
   if (o->left->isSlice()) {
     auto slice = dynamic_cast<const Slice*>(o->left);
-    middle(slice->single << ".set");
+    auto named = element_of(slice);
+    if (named && views.count(named->number)) {
+      middle(named->name << "_view_.set");
+    } else {
+      middle(slice->single << ".set");
+    }
     middle("(libbirch::make_slice(" << slice->brackets << "), " << o->right << ')');
   } else {
     if (o->left->isMembership()) {
@@ -121,7 +144,12 @@ void birch::CppGenerator::visit(const Assign* o) {
 }
 
 void birch::CppGenerator::visit(const Slice* o) {
-  middle(o->single << ".get");
+  auto named = element_of(o);
+  if (named && views.count(named->number)) {
+    middle(named->name << "_view_.get");
+  } else {
+    middle(o->single << ".get");
+  }
   middle("(libbirch::make_slice(" << o->brackets << "))");
 }
 
@@ -297,7 +325,9 @@ void birch::CppGenerator::visit(const LocalVariable* o) {
   if (o->has(LET)) {
     start("auto " << o->name);
   } else {
-    start(o->type << ' ' << o->name);
+    start("");
+    genType(o);
+    middle(' ' << o->name);
   }
   genInit(o);
   finish(';');
@@ -631,6 +661,15 @@ void birch::CppGenerator::visit(const Parallel* o) {
   line("{");
   in();
   genTraceFunction("<parallel for>", o->loc);
+
+  /* each thread accesses elements of arrays through its own view, rather
+   * than pinning the array for each access, so that threads do not contend
+   * for the lock of the array */
+  auto views = getViews(o);
+  for (auto named : views) {
+    line("auto " << named->name << "_view_ = " << named << ".view();");
+    this->views.insert(named->number);
+  }
   start("#pragma omp for schedule(");
   if (o->has(DYNAMIC)) {
     middle("guided");
@@ -644,6 +683,9 @@ void birch::CppGenerator::visit(const Parallel* o) {
   *this << o->braces->strip();
   out();
   line("}");
+  for (auto named : views) {
+    this->views.erase(named->number);
+  }
   out();
   line("}");
 }
@@ -759,12 +801,96 @@ void birch::CppGenerator::visit(const TypeList* o) {
   middle(o->head << ", " << o->tail);
 }
 
+void birch::CppGenerator::genType(const LocalVariable* o) {
+  auto type = dynamic_cast<const ArrayType*>(o->type);
+  bool isStatic = type && type->single->isBasic() &&
+      !o->has(REASSIGNED) && !o->brackets->isEmpty() &&
+      o->brackets->width() <= 2;
+  for (auto iter = o->brackets->begin(); isStatic &&
+      iter != o->brackets->end(); ++iter) {
+    auto literal = dynamic_cast<const Literal<int64_t>*>(*iter);
+    isStatic = literal && std::stoll(literal->str, nullptr, 0) > 0;
+  }
+  if (isStatic) {
+    middle("libbirch::StaticArray<" << type->single);
+    for (auto iter = o->brackets->begin(); iter != o->brackets->end();
+        ++iter) {
+      middle(',' << dynamic_cast<const Literal<int64_t>*>(*iter)->str);
+    }
+    middle('>');
+  } else {
+    middle(o->type);
+  }
+}
+
 std::string birch::CppGenerator::getIndex(const Statement* o) {
   auto index = dynamic_cast<const LocalVariable*>(o);
   assert(index);
   return internalise(index->name->str());
 }
 
+std::list<const birch::NamedExpression*> birch::CppGenerator::getViews(
+    const Parallel* o) {
+  std::list<const NamedExpression*> views;
+
+  /* lambda functions capture by value, which would copy a view, and raw C++
+   * code may use an array in any way, so neither is analyzed */
+  Gatherer<LambdaFunction> lambdas;
+  Gatherer<Raw> raws;
+  o->braces->accept(&lambdas);
+  o->braces->accept(&raws);
+  if (lambdas.size() > 0 || raws.size() > 0) {
+    return views;
+  }
+
+  /* arrays declared within the loop do not exist before it */
+  std::set<int> declared;
+  Gatherer<LocalVariable> locals;
+  o->braces->accept(&locals);
+  for (auto local : locals) {
+    declared.insert(local->number);
+  }
+
+  /* count all uses of each array, and those that access a single element;
+   * only local variables are considered, as a member variable may be
+   * reassigned or resized by any function called within the loop, even one
+   * called within an element expression or by an operator, after which its
+   * view would refer to a stale buffer */
+  std::map<int,const NamedExpression*> arrays;
+  std::map<int,int> nuses, nelements;
+  std::set<int> assigned;
+  Gatherer<NamedExpression> uses([](const NamedExpression* o) {
+        return o->category == LOCAL_VARIABLE && o->type->isArray();
+      });
+  Gatherer<Slice> elements([](const Slice* o) {
+        return element_of(o) != nullptr;
+      });
+  Gatherer<Assign> assigns([](const Assign* o) {
+        return element_of(o->left) != nullptr;
+      });
+  o->braces->accept(&uses);
+  o->braces->accept(&elements);
+  o->braces->accept(&assigns);
+  for (auto use : uses) {
+    arrays.insert(std::make_pair(use->number, use));
+    ++nuses[use->number];
+  }
+  for (auto element : elements) {
+    ++nelements[element_of(element)->number];
+  }
+  for (auto assign : assigns) {
+    assigned.insert(element_of(assign->left)->number);
+  }
+  for (auto pair : arrays) {
+    auto number = pair.first;
+    if (assigned.count(number) && !declared.count(number) &&
+        nuses[number] == nelements[number]) {
+      views.push_back(pair.second);
+    }
+  }
+  return views;
+}
+
 void birch::CppGenerator::genTraceFunction(const std::string& name,
     const Location* loc) {
   genSourceLine(loc);
@@ -114,11 +114,28 @@ protected:
   template<class T>
   void genInit(const T* o);
 
+  /**
+   * Generate the type of a local variable. An array of basic type with sizes
+   * that are all positive integer literals has static lengths, which the
+   * compiler can use to optimize element access and linear algebra (see
+   * libbirch::StaticArray), unless it is assigned as a whole after its
+   * declaration, when its lengths may change.
+   */
+  void genType(const LocalVariable* o);
+
   /**
    * Generate the name of a loop index.
    */
   virtual std::string getIndex(const Statement* o);
 
+  /**
+   * Gather the arrays to access through views within a parallel loop. These
+   * are local variables declared outside the loop, single elements of which
+   * are assigned within it, and which are not otherwise used within it
+   * except to access single elements.
+   */
+  std::list<const NamedExpression*> getViews(const Parallel* o);
+
   /**
    * Generate macro to put function call on stack trace.
    */
@@ -185,6 +202,12 @@ protected:
    * Are we in a return statement?
    */
   int inReturn;
+
+  /**
+   * Numbers of the arrays accessed through views in the current parallel
+   * loop.
+   */
+  std::set<int> views;
 };
 }
 
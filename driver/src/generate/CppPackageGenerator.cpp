@@ -4,6 +4,7 @@
 #include "src/generate/CppPackageGenerator.hpp"
 
 #include "src/generate/CppClassGenerator.hpp"
+#include "src/visitor/AcyclicTester.hpp"
 #include "src/visitor/Gatherer.hpp"
 #include "src/primitive/poset.hpp"
 #include "src/primitive/inherits.hpp"
@@ -83,6 +84,32 @@ void birch::CppPackageGenerator::visit(const Package* o) {
     }
     line("");
 
+    /* acyclic classes; these specializations precede the class definitions,
+     * so that they precede any use of the pointers that they affect */
+    AcyclicTester acyclic(o);
+    std::list<const Class*> acyclicClasses;
+    for (auto o : classes) {
+      if (acyclic.test(o)) {
+        acyclicClasses.push_back(o);
+      }
+    }
+    if (!acyclicClasses.empty()) {
+      line("}");
+      line("}\n");
+      line("namespace libbirch {");
+      for (auto o : acyclicClasses) {
+        line("template<unsigned N>");
+        line("struct is_acyclic_class<birch::type::" << o->name << ",N> {");
+        in();
+        line("static const bool value = true;");
+        out();
+        line("};\n");
+      }
+      line("}\n");
+      line("namespace birch {");
+      line("namespace type {");
+    }
+
     /* basic type aliases */
     for (auto o : basics) {
       if (o->isAlias()) {
@@ -0,0 +1,84 @@
+/**
+ * @file
+ */
+#include "src/visitor/AcyclicTester.hpp"
+
+#include "src/visitor/Gatherer.hpp"
+
+birch::AcyclicTester::AcyclicTester(const Package* o) :
+    acyclic(true) {
+  Gatherer<Class> gatherer;
+  o->accept(&gatherer);
+  for (auto o : gatherer) {
+    classes.insert(std::make_pair(o->number, o));
+  }
+}
+
+birch::AcyclicTester::~AcyclicTester() {
+  //
+}
+
+bool birch::AcyclicTester::test(const Class* o) {
+  auto iter = tested.find(o);
+  if (iter != tested.end()) {
+    return iter->second;
+  }
+  if (!testing.insert(o).second) {
+    /* the class can reach itself */
+    return false;
+  }
+
+  auto outer = acyclic;
+  acyclic = !o->isGeneric() && !o->isAlias() && !o->braces->isEmpty();
+  if (acyclic) {
+    auto base = dynamic_cast<const NamedType*>(o->base);
+    if (base) {
+      /* the base class need not be final, only acyclic */
+      auto iter = classes.find(base->number);
+      acyclic = base->isClass() && base->typeArgs->isEmpty() &&
+          iter != classes.end() && test(iter->second);
+    }
+  }
+  if (acyclic) {
+    Gatherer<MemberVariable> memberVariables;
+    o->accept(&memberVariables);
+    for (auto iter = memberVariables.begin(); acyclic &&
+        iter != memberVariables.end(); ++iter) {
+      (*iter)->type->accept(this);
+    }
+  }
+  auto result = acyclic;
+  acyclic = outer;
+
+  testing.erase(o);
+  tested.insert(std::make_pair(o, result));
+  return result;
+}
+
+void birch::AcyclicTester::visit(const NamedType* o) {
+  if (o->isClass()) {
+    auto iter = classes.find(o->number);
+    if (!o->typeArgs->isEmpty() || iter == classes.end()) {
+      acyclic = false;
+    } else if (iter->second->isAlias()) {
+      iter->second->base->accept(this);
+    } else {
+      /* pointers are polymorphic, so the class must also be final, c.f.
+       * libbirch::is_acyclic<Shared<T>> */
+      acyclic = acyclic && iter->second->has(FINAL) && test(iter->second);
+    }
+  } else if (o->isGeneric()) {
+    acyclic = false;
+  } else {
+    Visitor::visit(o);
+  }
+}
+
+void birch::AcyclicTester::visit(const MemberType* o) {
+  o->right->accept(this);
+}
+
+void birch::AcyclicTester::visit(const FunctionType* o) {
+  /* may capture pointers */
+  acyclic = false;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "src/visitor/Visitor.hpp"
+
+namespace birch {
+/**
+ * Determine which classes can never be part of a reference cycle, other than
+ * through the labels of their objects, from the types of their member
+ * variables. A class is acyclic if its base class is acyclic, and each of its
+ * member variables is of value type, or of pointer type to a final class
+ * that is itself acyclic. A class that can reach itself through such
+ * pointers is not acyclic, nor is a generic class.
+ *
+ * @ingroup visitor
+ */
+class AcyclicTester: public Visitor {
+public:
+  /**
+   * Constructor.
+   *
+   * @param o Package, including headers, in which to look up classes.
+   */
+  AcyclicTester(const Package* o);
+
+  /**
+   * Destructor.
+   */
+  virtual ~AcyclicTester();
+
+  /**
+   * Is a class acyclic?
+   */
+  bool test(const Class* o);
+
+  using Visitor::visit;
+  virtual void visit(const NamedType* o);
+  virtual void visit(const MemberType* o);
+  virtual void visit(const FunctionType* o);
+
+private:
+  /**
+   * Classes, by number.
+   */
+  std::unordered_map<int,const Class*> classes;
+
+  /**
+   * Classes already tested, with the results.
+   */
+  std::unordered_map<const Class*,bool> tested;
+
+  /**
+   * Classes currently being tested.
+   */
+  std::unordered_set<const Class*> testing;
+
+  /**
+   * Are all types visited so far acyclic?
+   */
+  bool acyclic;
+};
+}
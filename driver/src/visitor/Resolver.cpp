@@ -59,6 +59,12 @@ birch::Expression* birch::Resolver::modify(NamedExpression* o) {
   return o;
 }
 
+birch::Expression* birch::Resolver::modify(Assign* o) {
+  ScopedModifier::modify(o);
+  reassign(o->left);
+  return o;
+}
+
 birch::Type* birch::Resolver::modify(NamedType* o) {
   ScopedModifier::modify(o);
   for (auto iter = scopes.rbegin(); iter != scopes.rend() && !o->category;
@@ -75,3 +81,25 @@ birch::Statement* birch::Resolver::modify(Class* o) {
   scopes.back()->inherit(o);
   return ScopedModifier::modify(o);
 }
+
+void birch::Resolver::reassign(Expression* o) {
+  auto parens = dynamic_cast<Parentheses*>(o);
+  auto list = dynamic_cast<ExpressionList*>(o);
+  auto named = dynamic_cast<NamedExpression*>(o);
+  if (parens) {
+    reassign(parens->single);
+  } else if (list) {
+    reassign(list->head);
+    reassign(list->tail);
+  } else if (named && named->category == LOCAL_VARIABLE) {
+    auto name = named->name->str();
+    for (auto scope : scopes) {
+      auto range = scope->localVariables.equal_range(name);
+      for (auto iter = range.first; iter != range.second; ++iter) {
+        if (iter->second->number == named->number) {
+          iter->second->set(REASSIGNED);
+        }
+      }
+    }
+  }
+}
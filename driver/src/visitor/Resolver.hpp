@@ -33,7 +33,16 @@ public:
   virtual Expression* modify(Parameter* o);
   virtual Statement* modify(LocalVariable* o);
   virtual Expression* modify(NamedExpression* o);
+  virtual Expression* modify(Assign* o);
   virtual Type* modify(NamedType* o);
   virtual Statement* modify(Class* o);
+
+private:
+  /**
+   * Annotate the local variables assigned as a whole by the left side of an
+   * assignment as REASSIGNED. The left side may be a single variable, or a
+   * tuple of them.
+   */
+  void reassign(Expression* o);
 };
 }
@@ -5,6 +5,7 @@
  */
 #pragma once
 
+#include "src/visitor/AcyclicTester.hpp"
 #include "src/visitor/Baser.hpp"
 #include "src/visitor/Cloner.hpp"
 #include "src/visitor/ContextualModifier.hpp"
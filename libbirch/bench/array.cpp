@@ -0,0 +1,51 @@
+/**
+ * @file
+ *
+ * Microbenchmark for resizing one-dimensional arrays, reporting the time per
+ * element against array length, as for the `pushBack()`, `pushFront()` and
+ * `popFront()` member functions of the standard library's `Array` class.
+ *
+ * Three patterns are measured:
+ *
+ *   - *back*: insert elements at the back until the array has the given
+ *     length,
+ *   - *front*: insert elements at the front until the array has the given
+ *     length,
+ *   - *queue*: as *back*, then erase elements from the front until the array
+ *     is empty.
+ *
+ * Usage:
+ *
+ *     bench/array [maxlength]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+using Vector = libbirch::DefaultArray<double,1>;
+
+int main(int argc, char** argv) {
+  int maxlength = argc > 1 ? std::atoi(argv[1]) : 100000;
+
+  std::cout << "length\tpattern\tnanoseconds" << std::endl;
+  for (int n = 100; n <= maxlength; n *= 10) {
+    for (auto pattern : { "back", "front", "queue" }) {
+      auto start = std::chrono::steady_clock::now();
+      Vector x;
+      for (int i = 0; i < n; ++i) {
+        x.insert(pattern[0] == 'f' ? 0 : i, double(i));
+      }
+      if (pattern[0] == 'q') {
+        for (int i = 0; i < n; ++i) {
+          x.erase(0);
+        }
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << n << '\t' << pattern << '\t' << elapsed.count()/n*1.0e9 <<
+          std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file
+ *
+ * Microbenchmark for the balance of cycle collection between threads,
+ * reporting the time that each thread spends on each phase of a collection
+ * (see libbirch::CollectTimings). Rings of objects are created and
+ * discarded by one thread only, so that all possible roots are registered
+ * by that thread, as for the copies made by a resample under dynamic
+ * scheduling. Each ring holds an array, so that destruction is not trivial.
+ *
+ * Usage:
+ *
+ *     bench/balance [nrings] [nnodes]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Node of a ring.
+ */
+class Node : public libbirch::Any {
+public:
+  using class_type_ = Node;
+  using this_type_ = Node;
+  using super_type_ = libbirch::Any;
+
+  Node() :
+      x(libbirch::make_array<double>(libbirch::make_shape(16), 0.0)) {
+    //
+  }
+
+  libbirch::Optional<libbirch::Lazy<libbirch::Shared<Node>>> next;
+  libbirch::DefaultArray<double,1> x;
+
+  LIBBIRCH_CLASS(Node, libbirch::Any)
+  LIBBIRCH_MEMBERS(next, x)
+};
+}
+}
+
+using Pointer = libbirch::Lazy<libbirch::Shared<birch::type::Node>>;
+
+int main(int argc, char** argv) {
+  int nrings = argc > 1 ? std::atoi(argv[1]) : 1000;
+  int nnodes = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  libbirch::set_collect_threshold(0u, 0u);
+  for (int r = 0; r < nrings; ++r) {
+    Pointer head;
+    Pointer node = head;
+    for (int i = 1; i < nnodes; ++i) {
+      Pointer next;
+      node->next = next;
+      node = next;
+    }
+    node->next = head;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  libbirch::collect();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::cout << "thread\troots\tmerge\tmark\tscan\tcollect\tdestroy\t" <<
+      "release" << std::endl;
+  auto timings = libbirch::collect_timings();
+  for (size_t i = 0; i < timings.size(); ++i) {
+    auto& t = timings[i];
+    std::cout << i << '\t' << t.nroots << '\t' << t.merge*1.0e3 << '\t' <<
+        t.mark*1.0e3 << '\t' << t.scan*1.0e3 << '\t' << t.collect*1.0e3 <<
+        '\t' << t.destroy*1.0e3 << '\t' << t.release*1.0e3 << std::endl;
+  }
+  std::cout << "total (ms): " << elapsed.count()*1.0e3 << std::endl;
+  return 0;
+}
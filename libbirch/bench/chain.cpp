@@ -0,0 +1,137 @@
+/**
+ * @file
+ *
+ * Microbenchmark for lookups through long chains of memo entries, reporting
+ * the time to modify the first few nodes of every particle through second
+ * pointers to them, against the number of generations since those pointers
+ * were last followed, along with the average chain and probe lengths of the
+ * lookups (see libbirch::Stats).
+ *
+ * Each particle is a linked list in which every node also has a second
+ * pointer to itself. At the first step, every particle modifies all nodes
+ * of its list, so that the memo of each label is large, and at subsequent
+ * steps only the first few, through the first pointers; the population is
+ * then resampled, with each particle cloned from an ancestor. The first few
+ * nodes are therefore copied once per generation, but the second pointers
+ * are followed only every few generations, so that their lookups follow a
+ * chain of entries, mostly in trie nodes shared with ancestor labels.
+ *
+ * Usage:
+ *
+ *     bench/chain [nparticles] [nnodes] [nmodified] [maxperiod]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Node of a linked list.
+ */
+class Node : public libbirch::Any {
+public:
+  using class_type_ = Node;
+  using this_type_ = Node;
+  using super_type_ = libbirch::Any;
+
+  Node() :
+      x(0.0) {
+    //
+  }
+
+  libbirch::Optional<libbirch::Lazy<libbirch::Shared<Node>>> next;
+  libbirch::Optional<libbirch::Lazy<libbirch::Shared<Node>>> self;
+  double x;
+
+  LIBBIRCH_CLASS(Node, libbirch::Any)
+  LIBBIRCH_MEMBERS(next, self, x)
+};
+}
+}
+
+using Pointer = libbirch::Lazy<libbirch::Shared<birch::type::Node>>;
+
+int main(int argc, char** argv) {
+  int nparticles = argc > 1 ? std::atoi(argv[1]) : 100;
+  int nnodes = argc > 2 ? std::atoi(argv[2]) : 1000;
+  int nmodified = argc > 3 ? std::atoi(argv[3]) : 10;
+  int maxperiod = argc > 4 ? std::atoi(argv[4]) : 16;
+
+  libbirch::set_stats(true);
+  std::cout << "period\tmicroseconds\tchain\tprobe\tcompressions" <<
+      std::endl;
+  for (int period = 1; period <= maxperiod; period *= 2) {
+    Pointer head;
+    head->self = head;
+    for (int i = 1; i < nnodes; ++i) {
+      Pointer node;
+      node->next = head;
+      node->self = node;
+      head = node;
+    }
+    std::vector<Pointer> xs(nparticles, Pointer(nullptr));
+    for (int n = 0; n < nparticles; ++n) {
+      xs[n] = libbirch::clone(head);
+    }
+    head = Pointer(nullptr);
+
+    double elapsed = 0.0;
+    libbirch::Stats stats{};  // value initialization zeros the counts
+    for (int t = 0; t <= 4*maxperiod; ++t) {
+      /* modify through the first pointers */
+      #pragma omp parallel for schedule(guided)
+      for (int n = 0; n < nparticles; ++n) {
+        Pointer x = xs[n];
+        for (int i = 0; i < (t == 0 ? nnodes : nmodified); ++i) {
+          x->x += 1.0;
+          if (!x->next.query()) {
+            break;
+          }
+          x = x->next.get();
+        }
+      }
+
+      /* modify through the second pointers, every few generations */
+      if (t > 0 && t % period == 0) {
+        libbirch::reset_stats();
+        auto start = std::chrono::steady_clock::now();
+        #pragma omp parallel for schedule(guided)
+        for (int n = 0; n < nparticles; ++n) {
+          Pointer x = xs[n];
+          for (int i = 0; i < nmodified; ++i) {
+            x->self.get()->x += 1.0;
+            if (!x->next.query()) {
+              break;
+            }
+            x = x->next.get();
+          }
+        }
+        std::chrono::duration<double> d =
+            std::chrono::steady_clock::now() - start;
+        elapsed += d.count();
+        auto s = libbirch::stats();
+        stats.nchains += s.nchains;
+        stats.nlookups += s.nlookups;
+        stats.nlinks += s.nlinks;
+        stats.nprobes += s.nprobes;
+        stats.ncompressions += s.ncompressions;
+      }
+
+      /* resample, with each particle having zero or two offspring */
+      std::vector<Pointer> ys(nparticles, Pointer(nullptr));
+      #pragma omp parallel for schedule(guided)
+      for (int n = 0; n < nparticles; ++n) {
+        ys[n] = libbirch::clone(xs[n/2*2]);
+      }
+      xs = ys;
+      ys.clear();
+      libbirch::collect();
+    }
+    std::cout << period << '\t' << elapsed/(4*maxperiod/period)*1.0e6 <<
+        '\t' << stats.chainLength() << '\t' << stats.probeLength() << '\t' <<
+        stats.ncompressions << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file
+ *
+ * Microbenchmark for lazy deep copy, reporting the time per step of a
+ * particle-filter-like workload in which each particle is a linked list.
+ * Each particle is initially a clone of the same list, which is kept alive
+ * throughout, along with a second pointer to each of its nodes. At the first step, every particle modifies all nodes of its
+ * list, and at subsequent steps only the first few; the population is then
+ * resampled, with each particle cloned from an ancestor. The memo of each
+ * label thus retains an entry for every node of the original list, exposing
+ * the cost of a clone with respect to memo size.
+ *
+ * Usage:
+ *
+ *     bench/clone [nparticles] [nnodes] [nmodified] [nsteps]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Node of a linked list.
+ */
+class Node : public libbirch::Any {
+public:
+  using class_type_ = Node;
+  using this_type_ = Node;
+  using super_type_ = libbirch::Any;
+
+  Node() :
+      x(0.0) {
+    //
+  }
+
+  libbirch::Optional<libbirch::Lazy<libbirch::Shared<Node>>> next;
+  double x;
+
+  LIBBIRCH_CLASS(Node, libbirch::Any)
+  LIBBIRCH_MEMBERS(next, x)
+};
+}
+}
+
+using Pointer = libbirch::Lazy<libbirch::Shared<birch::type::Node>>;
+
+int main(int argc, char** argv) {
+  int nparticles = argc > 1 ? std::atoi(argv[1]) : 1000;
+  int nnodes = argc > 2 ? std::atoi(argv[2]) : 1000;
+  int nmodified = argc > 3 ? std::atoi(argv[3]) : 10;
+  int nsteps = argc > 4 ? std::atoi(argv[4]) : 20;
+
+  /* initial list, cloned for each particle; a second pointer to each node
+   * is kept so that the nodes are memoized when copied */
+  std::vector<Pointer> nodes;
+  nodes.push_back(Pointer());
+  for (int i = 1; i < nnodes; ++i) {
+    Pointer next;
+    nodes.back()->next = next;
+    nodes.push_back(next);
+  }
+  Pointer head = nodes.front();
+  std::vector<Pointer> xs(nparticles, Pointer(nullptr));
+  for (int n = 0; n < nparticles; ++n) {
+    xs[n] = libbirch::clone(head);
+  }
+
+  std::cout << "step\tseconds\theap" << std::endl;
+  for (int t = 0; t < nsteps; ++t) {
+    auto start = std::chrono::steady_clock::now();
+
+    /* modify */
+    #pragma omp parallel for schedule(guided)
+    for (int n = 0; n < nparticles; ++n) {
+      Pointer x = xs[n];
+      for (int i = 0; i < (t == 0 ? nnodes : nmodified); ++i) {
+        x->x += 1.0;
+        if (!x->next.query()) {
+          break;
+        }
+        x = x->next.get();
+      }
+    }
+
+    /* resample, with each particle having zero or two offspring */
+    std::vector<Pointer> ys(nparticles, Pointer(nullptr));
+    #pragma omp parallel for schedule(guided)
+    for (int n = 0; n < nparticles; ++n) {
+      ys[n] = libbirch::clone(xs[n/2*2]);
+    }
+    xs = ys;
+    ys.clear();
+    libbirch::collect();
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << t << '\t' << elapsed.count() << '\t' <<
+        libbirch::heap_size() << std::endl;
+  }
+  return 0;
+}
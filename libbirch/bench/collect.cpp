@@ -0,0 +1,103 @@
+/**
+ * @file
+ *
+ * Microbenchmark for automatic cycle collection, reporting the mean and
+ * maximum time per step, and the heap size at the end, of a workload that
+ * creates a ring of objects at each step and then discards it, so that each
+ * ring is garbage only once its cycle is collected.
+ *
+ * Three modes are measured:
+ *
+ *   - *manual*: automatic collection is disabled, and collect() is called
+ *     every few steps, as after each resample of a particle filter,
+ *   - *full*: automatic collection, processing all possible roots,
+ *   - *incremental*: automatic collection, processing a bounded number of
+ *     possible roots each time.
+ *
+ * For automatic collection, collect_if_due() is called at the end of each
+ * step, as the filter and sample programs of the standard library do.
+ *
+ * Usage:
+ *
+ *     bench/collect [nnodes] [nsteps] [period] [nroots]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Node of a ring.
+ */
+class Node : public libbirch::Any {
+public:
+  using class_type_ = Node;
+  using this_type_ = Node;
+  using super_type_ = libbirch::Any;
+
+  Node() :
+      x(0.0) {
+    //
+  }
+
+  libbirch::Optional<libbirch::Lazy<libbirch::Shared<Node>>> next;
+  double x;
+
+  LIBBIRCH_CLASS(Node, libbirch::Any)
+  LIBBIRCH_MEMBERS(next, x)
+};
+}
+}
+
+using Pointer = libbirch::Lazy<libbirch::Shared<birch::type::Node>>;
+
+int main(int argc, char** argv) {
+  int nnodes = argc > 1 ? std::atoi(argv[1]) : 1000;
+  int nsteps = argc > 2 ? std::atoi(argv[2]) : 1000;
+  int period = argc > 3 ? std::atoi(argv[3]) : 100;
+  size_t nroots = argc > 4 ? std::atoi(argv[4]) : 20000;
+
+  std::cout << "mode\tmean\tmax\theap" << std::endl;
+  for (auto mode : { "manual", "full", "incremental" }) {
+    if (mode == std::string("manual")) {
+      libbirch::set_collect_threshold(0u, 0u);
+    } else {
+      libbirch::set_collect_threshold(nroots, 0u);
+    }
+    if (mode == std::string("incremental")) {
+      libbirch::set_collect_budget(nroots/10u);
+    } else {
+      libbirch::set_collect_budget(0u);
+    }
+
+    double total = 0.0, longest = 0.0;
+    for (int t = 0; t < nsteps; ++t) {
+      auto start = std::chrono::steady_clock::now();
+      Pointer head;
+      Pointer node = head;
+      for (int i = 1; i < nnodes; ++i) {
+        Pointer next;
+        node->next = next;
+        node = next;
+      }
+      node->next = head;
+      if (mode == std::string("manual")) {
+        if ((t + 1) % period == 0) {
+          libbirch::collect();
+        }
+      } else {
+        libbirch::collect_if_due();
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      total += elapsed.count();
+      longest = std::max(longest, elapsed.count());
+    }
+    std::cout << mode << '\t' << total/nsteps*1.0e6 << '\t' <<
+        longest*1.0e6 << '\t' << libbirch::heap_size() << std::endl;
+    libbirch::collect();
+  }
+  return 0;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file
+ *
+ * Microbenchmark for copying arrays of pointers, as when the particles of a
+ * particle filter are copied, reporting the time per copy against array
+ * length.
+ *
+ * Three patterns are measured:
+ *
+ *   - *copy*: copy the array,
+ *   - *read*: copy the array, then read one element of the copy,
+ *   - *write*: copy the array, then write one element of the copy.
+ *
+ * Usage:
+ *
+ *     bench/copy [maxlength] [ncopies]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Particle.
+ */
+class Particle : public libbirch::Any {
+public:
+  using class_type_ = Particle;
+  using this_type_ = Particle;
+  using super_type_ = libbirch::Any;
+
+  Particle() :
+      w(0.0) {
+    //
+  }
+
+  double w;
+
+  LIBBIRCH_CLASS(Particle, libbirch::Any)
+  LIBBIRCH_MEMBERS(w)
+};
+}
+}
+
+using Pointer = libbirch::Lazy<libbirch::Shared<birch::type::Particle>>;
+using Vector = libbirch::DefaultArray<Pointer,1>;
+
+int main(int argc, char** argv) {
+  int maxlength = argc > 1 ? std::atoi(argv[1]) : 100000;
+  int ncopies = argc > 2 ? std::atoi(argv[2]) : 100;
+
+  std::cout << "length\tpattern\tmicroseconds" << std::endl;
+  for (int n = 100; n <= maxlength; n *= 10) {
+    Vector x;
+    for (int i = 0; i < n; ++i) {
+      x.insert(i, Pointer());
+    }
+    for (auto pattern : { "copy", "read", "write" }) {
+      double w = 0.0;
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < ncopies; ++r) {
+        Vector y(x);
+        if (pattern[0] == 'r') {
+          w += y.get(libbirch::make_slice(r % n))->w;
+        } else if (pattern[0] == 'w') {
+          y.set(libbirch::make_slice(r % n), Pointer());
+        }
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << n << '\t' << pattern << '\t' <<
+          elapsed.count()/ncopies*1.0e6 + w << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file
+ *
+ * Microbenchmark for eager against lazy deep copy, reporting the time per
+ * step of a particle-filter-like workload against the number of objects in
+ * the state of each particle. Each particle is a linked list, as in
+ * bench/clone, but every node is modified at every step, as for the small
+ * state of models such as the SIR and PoissonGaussian examples. The
+ * population is then resampled, with each particle cloned from an ancestor.
+ *
+ * Two modes are measured:
+ *
+ *   - *lazy*: clone() makes lazy copies (the eager clone limit is zero),
+ *   - *eager*: clone() makes eager copies (the limit exceeds the number of
+ *     nodes).
+ *
+ * Usage:
+ *
+ *     bench/eager [nparticles] [maxnodes] [nsteps]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Node of a linked list.
+ */
+class Node : public libbirch::Any {
+public:
+  using class_type_ = Node;
+  using this_type_ = Node;
+  using super_type_ = libbirch::Any;
+
+  Node() :
+      x(0.0) {
+    //
+  }
+
+  libbirch::Optional<libbirch::Lazy<libbirch::Shared<Node>>> next;
+  double x;
+
+  LIBBIRCH_CLASS(Node, libbirch::Any)
+  LIBBIRCH_MEMBERS(next, x)
+};
+}
+}
+
+using Pointer = libbirch::Lazy<libbirch::Shared<birch::type::Node>>;
+
+int main(int argc, char** argv) {
+  int nparticles = argc > 1 ? std::atoi(argv[1]) : 1000;
+  int maxnodes = argc > 2 ? std::atoi(argv[2]) : 64;
+  int nsteps = argc > 3 ? std::atoi(argv[3]) : 20;
+
+  std::cout << "nodes\tmode\tmicroseconds" << std::endl;
+  for (int nnodes = 1; nnodes <= maxnodes; nnodes *= 4) {
+    for (bool eager : { false, true }) {
+      libbirch::set_eager_clone_limit(eager ? nnodes : 0);
+
+      Pointer head;
+      for (int i = 1; i < nnodes; ++i) {
+        Pointer node;
+        node->next = head;
+        head = node;
+      }
+      std::vector<Pointer> xs(nparticles, Pointer(nullptr));
+      for (int n = 0; n < nparticles; ++n) {
+        xs[n] = libbirch::clone(head);
+      }
+      head = Pointer(nullptr);
+
+      auto start = std::chrono::steady_clock::now();
+      for (int t = 0; t < nsteps; ++t) {
+        /* modify every node of every particle */
+        #pragma omp parallel for schedule(guided)
+        for (int n = 0; n < nparticles; ++n) {
+          Pointer x = xs[n];
+          while (true) {
+            x->x += 1.0;
+            if (!x->next.query()) {
+              break;
+            }
+            x = x->next.get();
+          }
+        }
+
+        /* resample, with each particle having zero or two offspring */
+        std::vector<Pointer> ys(nparticles, Pointer(nullptr));
+        #pragma omp parallel for schedule(guided)
+        for (int n = 0; n < nparticles; ++n) {
+          ys[n] = libbirch::clone(xs[n/2*2]);
+        }
+        xs = ys;
+        libbirch::collect();
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << nnodes << '\t' << (eager ? "eager" : "lazy") << '\t' <<
+          elapsed.count()/nsteps*1.0e6 << std::endl;
+    }
+  }
+  return 0;
+}
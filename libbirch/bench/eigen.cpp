@@ -0,0 +1,104 @@
+/**
+ * @file
+ *
+ * Microbenchmark for linear algebra on arrays, reporting the time per
+ * conjugate update of a matrix normal inverse Wishart (MNIW) distribution
+ * against dimension, as in the linear-Gaussian models of the standard
+ * library.
+ *
+ * Given prior precision `L` and precision-scaled mean `N`, and `n`
+ * observations with inputs `X` and outputs `Y`, the update computes:
+ *
+ *     L' = L + X'X
+ *     N' = N + X'Y
+ *     M' = inv(L')N'
+ *
+ * with the inverse by Cholesky factorization. Two patterns are measured:
+ *
+ *   - *strided*: arrays are mapped to Eigen with `toEigen()`, which admits
+ *     general strides, as for views,
+ *   - *aligned*: arrays are mapped to Eigen with `toEigenAligned()`, which
+ *     requires contiguous and aligned elements, as for arrays that are not
+ *     views.
+ *
+ * Usage:
+ *
+ *     bench/eigen [maxdim] [nobs]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+using Matrix = libbirch::DefaultArray<double,2>;
+
+/**
+ * Perform one update.
+ *
+ * @param L Prior precision; overwritten with the posterior precision.
+ * @param N Prior precision-scaled mean; overwritten with the posterior.
+ * @param M Posterior mean; overwritten.
+ * @param X Inputs.
+ * @param Y Outputs.
+ * @param aligned Use aligned maps?
+ */
+static void update(Matrix& L, Matrix& N, Matrix& M, const Matrix& X,
+    const Matrix& Y, const bool aligned) {
+  if (aligned) {
+    auto L1 = L.toEigenAligned();
+    auto N1 = N.toEigenAligned();
+    auto X1 = X.toEigenAligned();
+    auto Y1 = Y.toEigenAligned();
+    L1.noalias() += X1.transpose()*X1;
+    N1.noalias() += X1.transpose()*Y1;
+    M.toEigenAligned() = L1.llt().solve(N1);
+  } else {
+    auto L1 = L.toEigen();
+    auto N1 = N.toEigen();
+    auto X1 = X.toEigen();
+    auto Y1 = Y.toEigen();
+    L1.noalias() += X1.transpose()*X1;
+    N1.noalias() += X1.transpose()*Y1;
+    M.toEigen() = L1.llt().solve(N1);
+  }
+}
+
+int main(int argc, char** argv) {
+  int maxdim = argc > 1 ? std::atoi(argv[1]) : 256;
+  int nobs = argc > 2 ? std::atoi(argv[2]) : 16;
+
+  std::cout << "dim\tpattern\tmicroseconds" << std::endl;
+  for (int p = 4; p <= maxdim; p *= 4) {
+    auto X = libbirch::make_array_from_lambda<double>(
+        libbirch::make_shape(nobs, p),
+        [](int64_t i) { return double(i % 7) - 3.0; });
+    auto Y = libbirch::make_array_from_lambda<double>(
+        libbirch::make_shape(nobs, p),
+        [](int64_t i) { return double(i % 5) - 2.0; });
+    int nreps = 100000000/(p*p*(nobs + p)) + 10;
+
+    for (bool aligned : { false, true }) {
+      auto L = libbirch::make_array_from_lambda<double>(
+          libbirch::make_shape(p, p),
+          [p](int64_t i) { return i/p == i%p ? 1.0 : 0.0; });
+      auto N = libbirch::make_array<double>(
+          libbirch::make_shape(p, p), 0.0);
+      auto M = libbirch::make_array<double>(
+          libbirch::make_shape(p, p), 0.0);
+      if (aligned && !(L.isAligned() && N.isAligned() && M.isAligned() &&
+          X.isAligned() && Y.isAligned())) {
+        std::cout << p << '\t' << "aligned" << '\t' << "n/a" << std::endl;
+        continue;
+      }
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < nreps; ++r) {
+        update(L, N, M, X, Y, aligned);
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      std::cout << p << '\t' << (aligned ? "aligned" : "strided") << '\t' <<
+          elapsed.count()/nreps*1.0e6 << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file
+ *
+ * Microbenchmark for the finish and freeze operations of lazy deep copy,
+ * reporting the time per clone of a particle that is cloned repeatedly
+ * without modification, against the size of its object graph.
+ *
+ * The particle is a linked list, with a second pointer to each node kept so
+ * that the nodes are memoized when copied. Every node is modified once, so
+ * that the memo of the particle's label has an entry for every node; the
+ * particle is then cloned repeatedly, each clone from the last. Each clone
+ * finishes and freezes a new label, the memo of which is shared with the
+ * previous one, so the time per clone should not depend on the size of the
+ * list.
+ *
+ * Usage:
+ *
+ *     bench/finish [nclones]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Node of a linked list.
+ */
+class Node : public libbirch::Any {
+public:
+  using class_type_ = Node;
+  using this_type_ = Node;
+  using super_type_ = libbirch::Any;
+
+  Node() :
+      x(0.0) {
+    //
+  }
+
+  libbirch::Optional<libbirch::Lazy<libbirch::Shared<Node>>> next;
+  double x;
+
+  LIBBIRCH_CLASS(Node, libbirch::Any)
+  LIBBIRCH_MEMBERS(next, x)
+};
+}
+}
+
+using Pointer = libbirch::Lazy<libbirch::Shared<birch::type::Node>>;
+
+int main(int argc, char** argv) {
+  int nclones = argc > 1 ? std::atoi(argv[1]) : 1000;
+
+  std::cout << "nodes\tmicroseconds" << std::endl;
+  for (int nnodes = 100; nnodes <= 100000; nnodes *= 10) {
+    /* the objects of each size are released at the end of the iteration,
+     * and collected at the start of the next */
+    libbirch::collect();
+
+    /* original list, with a second pointer to each node */
+    std::vector<Pointer> nodes;
+    nodes.push_back(Pointer());
+    for (int i = 1; i < nnodes; ++i) {
+      Pointer next;
+      nodes.back()->next = next;
+      nodes.push_back(next);
+    }
+
+    /* clone, and modify every node of the clone */
+    Pointer x = libbirch::clone(nodes.front());
+    {
+      Pointer y = x;
+      while (true) {
+        y->x += 1.0;
+        if (!y->next.query()) {
+          break;
+        }
+        y = y->next.get();
+      }
+    }
+    x = libbirch::clone(x);  // warm up, the first clone visits everything
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < nclones; ++r) {
+      x = libbirch::clone(x);
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << nnodes << '\t' << elapsed.count()/nclones*1.0e6 <<
+        std::endl;
+  }
+  return 0;
+}
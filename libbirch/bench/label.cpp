@@ -0,0 +1,132 @@
+/**
+ * @file
+ *
+ * Microbenchmark for contention on a label, reporting throughput of pointer
+ * updates through the memo of a single label against thread count, as when
+ * many threads dereference pointers into the same cloned object graph, after
+ * the deep clone tests (`test_deep_clone_*`).
+ *
+ * A linked list is cloned and every node of the clone modified, so that the
+ * memo of the clone's label has an entry for every node. Each thread then
+ * repeatedly updates pointers to the original nodes through that label.
+ * Two patterns are measured:
+ *
+ *   - *pull*: updates for reading,
+ *   - *get*: updates for writing, which find that each node has already
+ *     been copied.
+ *
+ * Usage:
+ *
+ *     bench/label [nnodes] [nrounds]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Node of a linked list.
+ */
+class Node : public libbirch::Any {
+public:
+  using class_type_ = Node;
+  using this_type_ = Node;
+  using super_type_ = libbirch::Any;
+
+  Node() :
+      x(0.0) {
+    //
+  }
+
+  libbirch::Optional<libbirch::Lazy<libbirch::Shared<Node>>> next;
+  double x;
+
+  LIBBIRCH_CLASS(Node, libbirch::Any)
+  LIBBIRCH_MEMBERS(next, x)
+};
+}
+}
+
+using Pointer = libbirch::Lazy<libbirch::Shared<birch::type::Node>>;
+
+/**
+ * Run one round of the benchmark.
+ *
+ * @param nodes Original nodes.
+ * @param label Label of the clone.
+ * @param nthreads Number of threads.
+ * @param write Update pointers for writing?
+ */
+static void round(const std::vector<birch::type::Node*>& nodes,
+    libbirch::Label* label, const int nthreads, const bool write) {
+  #pragma omp parallel num_threads(nthreads)
+  {
+    for (auto node : nodes) {
+      Pointer x(node, label);
+      if (write) {
+        x.get();
+      } else {
+        x.pull();
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  int nnodes = argc > 1 ? std::atoi(argv[1]) : 10000;
+  int nrounds = argc > 2 ? std::atoi(argv[2]) : 20;
+  int maxthreads = libbirch::get_max_threads();
+
+  /* original list; a second pointer to each node is kept so that the nodes
+   * are memoized when copied */
+  std::vector<Pointer> originals;
+  originals.push_back(Pointer());
+  for (int i = 1; i < nnodes; ++i) {
+    Pointer next;
+    originals.back()->next = next;
+    originals.push_back(next);
+  }
+
+  /* clone, and modify every node of the clone */
+  Pointer head = libbirch::clone(originals.front());
+  Pointer x = head;
+  while (true) {
+    x->x += 1.0;
+    if (!x->next.query()) {
+      break;
+    }
+    x = x->next.get();
+  }
+
+  std::vector<birch::type::Node*> nodes;
+  for (auto& o : originals) {
+    nodes.push_back(o.pull());
+  }
+  auto label = head.getLabel();
+
+  /* thread counts to try: powers of two, then the maximum */
+  std::vector<int> nthreads;
+  for (int n = 1; n < maxthreads; n *= 2) {
+    nthreads.push_back(n);
+  }
+  nthreads.push_back(maxthreads);
+
+  std::cout << "threads\tpattern\tMops/s" << std::endl;
+  for (auto n : nthreads) {
+    for (bool write : { false, true }) {
+      round(nodes, label, n, write);  // warm up
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < nrounds; ++r) {
+        round(nodes, label, n, write);
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      double nops = double(n)*nnodes*nrounds;
+      std::cout << n << '\t' << (write ? "get" : "pull") << '\t' <<
+          nops/elapsed.count()/1.0e6 << std::endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,83 @@
+/**
+ * @file
+ *
+ * Microbenchmark for libbirch::allocate() and libbirch::deallocate(),
+ * reporting throughput against thread count.
+ *
+ * Two patterns are measured:
+ *
+ *   - *local*: each thread frees the blocks that it allocated,
+ *   - *remote*: each thread frees the blocks allocated by its neighbor, as
+ *     happens when particles are copied between threads during resampling.
+ *
+ * Usage:
+ *
+ *     bench/memory [nblocks] [nrounds]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+/**
+ * Sizes of blocks to allocate, cycled through.
+ */
+static const size_t sizes[] = { 48, 64, 72, 128, 200, 512 };
+static const int nsizes = sizeof(sizes)/sizeof(sizes[0]);
+
+/**
+ * Run one round of the benchmark.
+ *
+ * @param nthreads Number of threads.
+ * @param nblocks Number of blocks allocated per thread per round.
+ * @param remote Free blocks on a neighboring thread?
+ * @param blocks Storage for block pointers, of length `nthreads*nblocks`.
+ */
+static void round(const int nthreads, const int nblocks, const bool remote,
+    std::vector<void*>& blocks) {
+  #pragma omp parallel num_threads(nthreads)
+  {
+    int tid = libbirch::get_thread_num();
+    void** mine = blocks.data() + tid*nblocks;
+    for (int i = 0; i < nblocks; ++i) {
+      mine[i] = libbirch::allocate(sizes[i % nsizes]);
+    }
+    #pragma omp barrier
+    int owner = remote ? (tid + 1) % nthreads : tid;
+    void** theirs = blocks.data() + owner*nblocks;
+    for (int i = 0; i < nblocks; ++i) {
+      libbirch::deallocate(theirs[i], sizes[i % nsizes], owner);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  int nblocks = argc > 1 ? std::atoi(argv[1]) : 100000;
+  int nrounds = argc > 2 ? std::atoi(argv[2]) : 20;
+  int maxthreads = libbirch::get_max_threads();
+
+  /* thread counts to try: powers of two, then the maximum */
+  std::vector<int> nthreads;
+  for (int n = 1; n < maxthreads; n *= 2) {
+    nthreads.push_back(n);
+  }
+  nthreads.push_back(maxthreads);
+
+  std::vector<void*> blocks(maxthreads*nblocks);
+  std::cout << "threads\tpattern\tMops/s" << std::endl;
+  for (auto n : nthreads) {
+    for (bool remote : { false, true }) {
+      round(n, nblocks, remote, blocks);  // warm up pools
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < nrounds; ++r) {
+        round(n, nblocks, remote, blocks);
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      double nops = 2.0*n*nblocks*nrounds;
+      std::cout << n << '\t' << (remote ? "remote" : "local") << '\t' <<
+          nops/elapsed.count()/1.0e6 << std::endl;
+    }
+  }
+  return 0;
+}
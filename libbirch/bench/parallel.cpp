@@ -0,0 +1,143 @@
+/**
+ * @file
+ *
+ * Microbenchmark for the weight updates of `ParticleFilter.propagate()`,
+ * reporting throughput against thread count. As in the code generated for
+ * that function, each iteration of a parallel loop allocates a handler
+ * object, then updates one element of the weights with
+ * `w[n] <- w[n] + handler.w`; only the simulation of the model is omitted.
+ *
+ * Two patterns are measured:
+ *
+ *   - *member*: the weights are a member array, which is not accessed
+ *     through views, so that each write pins it,
+ *   - *local*: the weights are copied into a local array before the loop,
+ *     each thread writes through its own view of that, and the local array
+ *     is assigned back to the member after the loop.
+ *
+ * Usage:
+ *
+ *     bench/parallel [nparticles] [nrounds]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Handler, allocated for each particle.
+ */
+class Handler : public libbirch::Any {
+public:
+  using class_type_ = Handler;
+  using this_type_ = Handler;
+  using super_type_ = libbirch::Any;
+
+  Handler() :
+      w(1.0) {
+    //
+  }
+
+  double w;
+
+  LIBBIRCH_CLASS(Handler, libbirch::Any)
+  LIBBIRCH_MEMBERS(w)
+};
+
+/**
+ * Filter, with the weights as a member.
+ */
+class Filter : public libbirch::Any {
+public:
+  using class_type_ = Filter;
+  using this_type_ = Filter;
+  using super_type_ = libbirch::Any;
+
+  Filter(const int64_t nparticles) :
+      w(libbirch::make_shape(nparticles), 0.0) {
+    //
+  }
+
+  /**
+   * Update the weights, writing elements of the member array.
+   */
+  void propagateMember(const int nthreads) {
+    auto nparticles = w.size();
+    #pragma omp parallel num_threads(nthreads)
+    {
+      #pragma omp for schedule(static)
+      for (int64_t n = 1; n <= nparticles; ++n) {
+        libbirch::Lazy<libbirch::Shared<Handler>> handler;
+        w.set(libbirch::make_slice(n - 1),
+            w.get(libbirch::make_slice(n - 1)) + handler->w);
+      }
+    }
+  }
+
+  /**
+   * Update the weights, writing elements of a local copy.
+   */
+  void propagateLocal(const int nthreads) {
+    auto nparticles = this->w.size();
+    auto w = this->w;
+    #pragma omp parallel num_threads(nthreads)
+    {
+      auto w_view_ = w.view();
+      #pragma omp for schedule(static)
+      for (int64_t n = 1; n <= nparticles; ++n) {
+        libbirch::Lazy<libbirch::Shared<Handler>> handler;
+        w_view_.set(libbirch::make_slice(n - 1),
+            w_view_.get(libbirch::make_slice(n - 1)) + handler->w);
+      }
+    }
+    this->w = w;
+  }
+
+  libbirch::DefaultArray<double,1> w;
+
+  LIBBIRCH_CLASS(Filter, libbirch::Any)
+  LIBBIRCH_MEMBERS(w)
+};
+}
+}
+
+int main(int argc, char** argv) {
+  int nparticles = argc > 1 ? std::atoi(argv[1]) : 100000;
+  int nrounds = argc > 2 ? std::atoi(argv[2]) : 100;
+  int maxthreads = libbirch::get_max_threads();
+
+  libbirch::Lazy<libbirch::Shared<birch::type::Filter>> filter(nparticles);
+
+  /* thread counts to try: powers of two, then the maximum */
+  std::vector<int> nthreads;
+  for (int n = 1; n < maxthreads; n *= 2) {
+    nthreads.push_back(n);
+  }
+  nthreads.push_back(maxthreads);
+
+  std::cout << "threads\tpattern\tMops/s" << std::endl;
+  for (auto n : nthreads) {
+    for (bool local : { false, true }) {
+      auto round = [&]() {
+        if (local) {
+          filter->propagateLocal(n);
+        } else {
+          filter->propagateMember(n);
+        }
+      };
+      round();  // warm up
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < nrounds; ++r) {
+        round();
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      double nops = double(nparticles)*nrounds;
+      std::cout << n << '\t' << (local ? "local" : "member") << '\t' <<
+          nops/elapsed.count()/1.0e6 << std::endl;
+    }
+  }
+  return 0;
+}
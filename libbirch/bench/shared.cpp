@@ -0,0 +1,104 @@
+/**
+ * @file
+ *
+ * Microbenchmark for reference counting of libbirch::Shared, reporting
+ * throughput of pointer copies (each an increment and decrement of the
+ * shared count) against thread count.
+ *
+ * Two patterns are measured:
+ *
+ *   - *private*: each thread copies pointers to its own object,
+ *   - *shared*: all threads copy pointers to the same object, as happens
+ *     when particles share ancestral state after resampling.
+ *
+ * Usage:
+ *
+ *     bench/shared [ncopies] [nrounds]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Minimal class for the benchmark.
+ */
+class Object : public libbirch::Any {
+public:
+  using class_type_ = Object;
+  using this_type_ = Object;
+  using super_type_ = libbirch::Any;
+
+  int64_t x = 0;
+
+  LIBBIRCH_CLASS(Object, libbirch::Any)
+  LIBBIRCH_MEMBERS(x)
+};
+}
+}
+
+using Pointer = libbirch::Shared<birch::type::Object>;
+
+/**
+ * Run one round of the benchmark.
+ *
+ * @param objects Objects to copy, one per thread.
+ * @param ncopies Number of copies per thread per round.
+ * @param shared Copy the same object on all threads?
+ * @param copies Storage for copies, of length `ncopies` for each thread.
+ */
+static void round(const std::vector<Pointer>& objects, const int ncopies,
+    const bool shared, std::vector<std::vector<Pointer>>& copies) {
+  #pragma omp parallel num_threads(objects.size())
+  {
+    int tid = libbirch::get_thread_num();
+    auto& o = objects[shared ? 0 : tid];
+    auto& mine = copies[tid];
+    for (int i = 0; i < ncopies; ++i) {
+      mine[i] = o;
+    }
+    for (int i = 0; i < ncopies; ++i) {
+      mine[i].release();
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  int ncopies = argc > 1 ? std::atoi(argv[1]) : 100000;
+  int nrounds = argc > 2 ? std::atoi(argv[2]) : 20;
+  int maxthreads = libbirch::get_max_threads();
+
+  /* thread counts to try: powers of two, then the maximum */
+  std::vector<int> nthreads;
+  for (int n = 1; n < maxthreads; n *= 2) {
+    nthreads.push_back(n);
+  }
+  nthreads.push_back(maxthreads);
+
+  std::vector<std::vector<Pointer>> copies(maxthreads,
+      std::vector<Pointer>(ncopies));
+  std::cout << "threads\tpattern\tMops/s" << std::endl;
+  for (auto n : nthreads) {
+    /* each thread allocates its own object */
+    std::vector<Pointer> objects(n);
+    #pragma omp parallel num_threads(n)
+    {
+      objects[libbirch::get_thread_num()] = Pointer(new birch::type::Object());
+    }
+    for (bool shared : { false, true }) {
+      round(objects, ncopies, shared, copies);  // warm up
+      auto start = std::chrono::steady_clock::now();
+      for (int r = 0; r < nrounds; ++r) {
+        round(objects, ncopies, shared, copies);
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      double nops = 2.0*n*ncopies*nrounds;
+      std::cout << n << '\t' << (shared ? "shared" : "private") << '\t' <<
+          nops/elapsed.count()/1.0e6 << std::endl;
+    }
+  }
+  return 0;
+}
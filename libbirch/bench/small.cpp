@@ -0,0 +1,55 @@
+/**
+ * @file
+ *
+ * Microbenchmark for arithmetic on short vectors, reporting the time per
+ * simulation from a multivariate Gaussian distribution against dimension, as
+ * for the state of the linear-Gaussian models of the standard library.
+ *
+ * Each simulation computes `x = μ + Lz`, as in
+ * `simulate_multivariate_gaussian()`, where `L` is the Cholesky factor of the
+ * covariance and `z` a vector of standard normal variates. The arrays `x`,
+ * `Lz` and `z` are all created anew, as temporaries would be. Arrays with
+ * few enough elements do not allocate (@see SmallBuffer), so the time per
+ * simulation increases at the dimension where they start to.
+ *
+ * Usage:
+ *
+ *     bench/small [maxdim] [nsims]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+using Vector = libbirch::DefaultArray<double,1>;
+using Matrix = libbirch::DefaultArray<double,2>;
+
+int main(int argc, char** argv) {
+  int maxdim = argc > 1 ? std::atoi(argv[1]) : 8;
+  int nsims = argc > 2 ? std::atoi(argv[2]) : 1000000;
+
+  std::cout << "dim\tnanoseconds" << std::endl;
+  for (int n = 1; n <= maxdim; ++n) {
+    auto mu = libbirch::make_array<double>(libbirch::make_shape(n), 1.0);
+    auto L = libbirch::make_array_from_lambda<double>(
+        libbirch::make_shape(n, n),
+        [n](int64_t i) { return i/n >= i%n ? 1.0 : 0.0; });
+    double sum = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < nsims; ++s) {
+      auto z = libbirch::make_array<double>(libbirch::make_shape(n),
+          double(s % 3));
+      Vector Lz = L.toEigen()*z.toEigen();
+      Vector x = mu.toEigen() + Lz.toEigen();
+      sum += x(libbirch::make_slice(n - 1));
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << n << '\t' << elapsed.count()/nsims*1.0e9 << std::endl;
+    if (sum < 0.0) {
+      std::cerr << sum << std::endl;  // so that the loop is not elided
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file
+ *
+ * Microbenchmark for arrays with static lengths, reporting the time per
+ * step of a linear-Gaussian state-space model with a four-dimensional state,
+ * as for the tracks of the multiple object tracking example. Each step
+ * updates the state as `x = Ax + z` with a fixed-size Eigen product, then
+ * writes and reads the elements of `z` one at a time.
+ *
+ * Two patterns are measured:
+ *
+ *   - *dynamic*: the arrays have the default shape,
+ *   - *static*: the arrays are StaticArray, as the driver generates for
+ *     declarations with literal sizes, e.g. `x:Real[4]`.
+ *
+ * Usage:
+ *
+ *     bench/static [nsteps]
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <chrono>
+#include <iostream>
+
+/**
+ * Run the benchmark.
+ *
+ * @tparam Vector Vector type.
+ * @tparam Matrix Matrix type.
+ *
+ * @param nsteps Number of steps.
+ *
+ * @return Time per step, in nanoseconds.
+ */
+template<class Vector, class Matrix>
+static double run(const int nsteps) {
+  Matrix A(libbirch::make_shape(4, 4), 0.0);
+  Vector x(libbirch::make_shape(4), 0.0);
+  Vector z(libbirch::make_shape(4), 0.0);
+  for (int i = 0; i < 4; ++i) {
+    A.set(libbirch::make_slice(i, i), 0.9);
+  }
+  for (int i = 0; i < 2; ++i) {
+    A.set(libbirch::make_slice(i, i + 2), 0.1);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (int s = 0; s < nsteps; ++s) {
+    double sum = 0.0;
+    for (int i = 0; i < 4; ++i) {
+      z.set(libbirch::make_slice(i), 0.01*((s + i) % 7));
+    }
+    for (int i = 0; i < 4; ++i) {
+      sum += z.get(libbirch::make_slice(i));
+    }
+    x.toEigen() = A.toEigen()*x.toEigen() + z.toEigen()*sum;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  if (x.get(libbirch::make_slice(0)) < 0.0) {
+    std::cerr << "negative" << std::endl;  // so that the loop is not elided
+  }
+  return elapsed.count()/nsteps*1.0e9;
+}
+
+int main(int argc, char** argv) {
+  int nsteps = argc > 1 ? std::atoi(argv[1]) : 10000000;
+
+  std::cout << "pattern\tnanoseconds" << std::endl;
+  std::cout << "dynamic\t" << run<libbirch::DefaultArray<double,1>,
+      libbirch::DefaultArray<double,2>>(nsteps) << std::endl;
+  std::cout << "static\t" << run<libbirch::StaticArray<double,4>,
+      libbirch::StaticArray<double,4,4>>(nsteps) << std::endl;
+  return 0;
+}
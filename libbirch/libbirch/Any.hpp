@@ -6,12 +6,16 @@
 #include "libbirch/external.hpp"
 #include "libbirch/assert.hpp"
 #include "libbirch/memory.hpp"
+#include "libbirch/stats.hpp"
+#include "libbirch/profile.hpp"
 #include "libbirch/Atomic.hpp"
 #include "libbirch/Init.hpp"
 #include "libbirch/LabelPtr.hpp"
 
 namespace libbirch {
 class Label;
+class Discoverer;
+class EagerCopier;
 
 /**
  * Base class providing reference counting, cycle breaking, and lazy deep
@@ -23,6 +27,13 @@ class Label;
  * it, must be assigned to at least one Shared pointer in its lifetime to
  * be correctly destroyed and deallocated. Furthermore, in order to work
  * correctly with multiple inheritance, Any must be the *first* base class.
+ *
+ * Defining ENABLE_COMPACT_HEADER reduces the header from 32 to 24 bytes (on
+ * 64-bit platforms), for programs made of many small objects. This gives up
+ * biased reference counting, so that all updates of the shared count are
+ * atomic, and limits the memo count to 20 bits. As with
+ * DISABLE_MEMORY_POOL, it must be defined for both the library and the
+ * packages that use it.
  */
 class Any {
 public:
@@ -33,12 +44,14 @@ public:
    * Constructor.
    */
   Any() :
-      label(root()),
-      sharedCount(0u),
+      label(),
+      sharedCount(INITIAL_SHARED),
+      #ifndef ENABLE_COMPACT_HEADER
+      localCount(0),
       memoCount(1u),
-      size(0u),
       tid(get_thread_num()),
-      flags(0u) {
+      #endif
+      flags(INITIAL_FLAGS) {
     //
   }
 
@@ -47,11 +60,13 @@ public:
    */
   Any(int) :
       label(nullptr),
-      sharedCount(0u),
+      sharedCount(INITIAL_SHARED),
+      #ifndef ENABLE_COMPACT_HEADER
+      localCount(0),
       memoCount(1u),
-      size(0u),
       tid(0),
-      flags(0u) {
+      #endif
+      flags(INITIAL_FLAGS) {
     //
   }
 
@@ -66,13 +81,16 @@ public:
    * Destructor.
    */
   virtual ~Any() {
-    assert(sharedCount.load() == 0u);
+    assert(numShared() == 0u);
+    label.~LabelPtr();
   }
 
   /**
-   * New operator.
+   * New operator. Before allocating, this merges objects of the current
+   * thread that other threads have released (@see merge_registered()).
    */
   void* operator new(std::size_t size) {
+    merge_registered();
     return allocate(size);
   }
 
@@ -96,6 +114,7 @@ public:
    */
   void finish(Label* label) {
     if (!(flags.exchangeOr(FINISHED) & FINISHED)) {
+      count_stat(&Stats::nfinished);
       finish_(label);
     }
   }
@@ -106,12 +125,13 @@ public:
   void freeze() {
     libbirch_assert_(isFinished());
     if (!(flags.exchangeOr(FROZEN) & FROZEN)) {
-      if (sharedCount.load() == 1u) {
+      if (numShared() == 1u) {
         // ^ small optimization: isUnique() makes sense, but unnecessarily
         //   loads memoCount as well, which is unnecessary for a objects
         //   that are not frozen
         flags.maskOr(FROZEN_UNIQUE);
       }
+      count_stat(&Stats::nfrozen);
       freeze_();
     }
   }
@@ -130,15 +150,40 @@ public:
    */
   Any* copy(Label* label) {
     auto o = copy_(label);
-    new (&o->label) decltype(o->label)(label);
-    o->sharedCount.store(0u);
-    o->memoCount.store(1u);
-    o->size = 0u;
-    o->tid = get_thread_num();
-    o->flags.store(0u);
+    o->reset(label);
+    o->profile();
     return o;
   }
 
+  /**
+   * Copy the object bitwise, as the first step of an eager copy (@see
+   * EagerMap). The copy is in the root label. Its member variables must
+   * then be fixed with copyEager_(), once all objects of the eager copy have
+   * been copied bitwise.
+   */
+  Any* copyEager() const {
+    auto size = size_();
+    auto o = static_cast<Any*>(libbirch::allocate(size));
+    std::memcpy(static_cast<void*>(o), static_cast<const void*>(this), size);
+    o->reset(nullptr);
+    o->profile();
+    return o;
+  }
+
+  /**
+   * Count the object in the heap profile, if it is enabled (@see
+   * set_heap_profile()). This is called once the object is fully
+   * constructed, as its class name and size are not available before then.
+   * The object is flagged as counted, so that it is discounted on
+   * destruction even if the heap profile has since been disabled.
+   */
+  void profile() {
+    if (heap_profile_enabled.loadRelaxed() &&
+        !(flags.exchangeOr(PROFILED) & PROFILED)) {
+      profile_new(getClassName(), size_());
+    }
+  }
+
   /**
    * Recycle the object. This can be used as an optimization in place of
    * copy(), where only one pointer remains to the source object, and it would
@@ -223,17 +268,26 @@ public:
    * Destroy, but do not deallocate, the object.
    */
   void destroy() {
-    assert(sharedCount.load() == 0u);
-    this->flags.maskOr(DESTROYED);
-    this->size = size_();
+    assert(numShared() == 0u);
+    auto old = this->flags.exchangeOr(DESTROYED);
+    auto size = size_();
+    if (old & PROFILED) {
+      profile_delete(getClassName(), size);
+    }
     this->~Any();
+    this->size = size;
   }
 
   /**
    * Shared count.
    */
   unsigned numShared() const {
-    return sharedCount.load();
+    auto shared = sharedCount.loadRelaxed();
+    int result = count(shared);
+    if (!(shared & MERGED)) {
+      result += local();
+    }
+    return std::max(result, 0);
   }
 
   /**
@@ -246,7 +300,11 @@ public:
     //   a performance issue, and as long as one thread can reach the object
     //   it is fine to be off
     // ^ disabling this option improves performance on several examples
-    sharedCount.increment();
+    if (isBiased()) {
+      setLocal(local() + 1);
+    } else {
+      sharedCount.incrementRelaxed();
+    }
   }
 
   /**
@@ -259,15 +317,24 @@ public:
 
     /* if the count will reduce to nonzero, this is possibly the root of
      * a cycle */
-    if (numShared() > 1u &&
-        !(flags.exchangeOr(BUFFERED|POSSIBLE_ROOT) & BUFFERED)) {
-      register_possible_root(this);
+    if (numShared() > 1u) {
+      possibleRoot();
     }
 
     /* decrement */
-    if (--sharedCount == 0u) {
-      destroy();
-      decMemo();
+    decSharedAcyclic();
+  }
+
+  /**
+   * Register the object as a possible root for cycle collection, if not
+   * already registered. This performs the `PossibleRoot()` operation of
+   * @ref Bacon2001 "Bacon & Rajan (2001)". It is called by decShared(), but
+   * also for references that are given up without decrementing the count,
+   * such as those of a buffer of pointers that is shared by other arrays.
+   */
+  void possibleRoot() {
+    if (!(flags.exchangeOr(BUFFERED|POSSIBLE_ROOT) & BUFFERED)) {
+      register_possible_root(this);
     }
   }
 
@@ -283,10 +350,53 @@ public:
    */
   void decSharedAcyclic() {
     assert(numShared() > 0u);
-    if (--sharedCount == 0u) {
-      destroy();
-      decMemo();
+    if (isBiased()) {
+      auto local = this->local() - 1;
+      setLocal(local);
+      if (local <= 0) {
+        merge();
+      }
+    } else {
+      auto shared = sharedCount.decrementAcqRel();
+      if (shared & MERGED) {
+        if (count(shared) == 0) {
+          destroy();
+          decMemo();
+        }
+      } else if (count(shared) <= 0 &&
+          !(flags.exchangeOr(MERGE_QUEUED) & MERGE_QUEUED)) {
+        /* the owning thread may hold the remaining references, or there may
+         * be none left; either way only it can tell, so have it merge */
+        register_merge(this, owner());
+      }
+    }
+  }
+
+  /**
+   * Decrement the shared count with a referent of known acyclic class (@see
+   * is_acyclic_class). The member variables of such an object cannot reach
+   * it again, but its label can, as the label holds the copies made with it,
+   * so that the object may still be part of a cycle through its label. If
+   * the new count is nonzero, the label rather than the object is registered
+   * as a possible root for cycle collection; there are few labels, and they
+   * are usually registered already, so the buffer of possible roots does not
+   * grow with the number of such objects.
+   */
+  void decSharedAcyclicClass() {
+    assert(numShared() > 0u);
+    if (numShared() > 1u) {
+      labelPossibleRoot();
     }
+    decSharedAcyclic();
+  }
+
+  /**
+   * Register the label of the object as a possible root for cycle
+   * collection, in place of the object itself. This is used for objects of
+   * acyclic class; see decSharedAcyclicClass().
+   */
+  void labelPossibleRoot() {
+    label.possibleRoot();
   }
 
   /**
@@ -297,29 +407,83 @@ public:
    */
   void decSharedReachable() {
     assert(numShared() > 0u);
-    sharedCount.decrement();
+    if (isBiased()) {
+      setLocal(local() - 1);
+    } else {
+      sharedCount.decrementRelease();
+    }
+  }
+
+  /**
+   * Decrement the shared count to break a reference during cycle collection.
+   * Unlike decSharedReachable(), this always operates on the shared part of
+   * the count, as the threads that break and later restore the reference
+   * need not be the same.
+   */
+  void breakShared() {
+    sharedCount.decrementRelease();
+  }
+
+  /**
+   * Increment the shared count to restore a reference broken with
+   * breakShared().
+   */
+  void restoreShared() {
+    sharedCount.incrementRelaxed();
   }
 
+  /**
+   * Merge the local part of the shared count into the shared part, so that
+   * the shared part becomes the whole count, destroying the object if that
+   * count is zero. Must only be called by the owning thread, or outside of
+   * any parallel region, when the owning thread cannot be updating the local
+   * part.
+   */
+  void merge() {
+    assert(owner() == get_thread_num() || !in_parallel());
+    if (!(sharedCount.loadRelaxed() & MERGED)) {
+      auto local = this->local();
+      setLocal(0);
+      auto shared = (sharedCount += MERGED + unsigned(local));
+      if (count(shared) == 0) {
+        destroy();
+        decMemo();
+      }
+    }
+  }
   /**
    * Memo count.
    */
   unsigned numMemo() const {
-    return memoCount.load();
+    #ifdef ENABLE_COMPACT_HEADER
+    return flags.loadRelaxed() >> MEMO_SHIFT;
+    #else
+    return memoCount.loadRelaxed();
+    #endif
   }
 
   /**
    * Increment the memo count.
    */
   void incMemo() {
-    memoCount.increment();
+    #ifdef ENABLE_COMPACT_HEADER
+    assert(numMemo() < (~0u >> MEMO_SHIFT));
+    flags.add(MEMO_ONE);
+    #else
+    memoCount.incrementRelaxed();
+    #endif
   }
 
   /**
    * Decrement the memo count.
    */
   void decMemo() {
-    assert(memoCount.load() > 0u);
-    if (--memoCount == 0u) {
+    assert(numMemo() > 0u);
+    #ifdef ENABLE_COMPACT_HEADER
+    if (((flags -= MEMO_ONE) >> MEMO_SHIFT) == 0u) {
+    #else
+    if (memoCount.decrementAcqRel() == 0u) {
+    #endif
       assert(numShared() == 0u);
       deallocate();
     }
@@ -336,14 +500,14 @@ public:
    * Has the object been destroyed?
    */
   bool isDestroyed() const {
-    return flags.load() & DESTROYED;
+    return flags.loadAcquire() & DESTROYED;
   }
 
   /**
    * Is this object the possible root of a cycle?
    */
   bool isPossibleRoot() const {
-    auto flags = this->flags.load();
+    auto flags = this->flags.loadAcquire();
     return (flags & POSSIBLE_ROOT) && !(flags & DESTROYED);
   }
 
@@ -358,14 +522,14 @@ public:
    * Is the object finished?
    */
   bool isFinished() const {
-    return flags.load() & FINISHED;
+    return flags.loadAcquire() & FINISHED;
   }
 
   /**
    * Is the object frozen?
    */
   bool isFrozen() const {
-    return flags.load() & FROZEN;
+    return flags.loadAcquire() & FROZEN;
   }
 
   /**
@@ -373,39 +537,103 @@ public:
    * shared pointer to it?
    */
   bool isFrozenUnique() const {
-    return flags.load() & FROZEN_UNIQUE;
+    return flags.loadAcquire() & FROZEN_UNIQUE;
+  }
+
+protected:
+  /**
+   * Disable biased reference counting for the object, so that its shared
+   * count is always updated atomically, and can be read exactly by any
+   * thread. Must be called before any references to the object are taken.
+   */
+  void unbias() {
+    assert(numShared() == 0u);
+    sharedCount.storeRelaxed(MERGED|COUNT_OFFSET);
+  }
+
+  /**
+   * Clear the finished and frozen flags of an object that is modified in
+   * place after being frozen, so that the next finish() and freeze() visit
+   * it again.
+   */
+  void unfreeze() {
+    flags.maskAnd(~(FINISHED|FROZEN|FROZEN_UNIQUE));
+  }
+
+  /**
+   * Set the finished flag of an object that was modified in place after
+   * being finished, without finishing its member variables again, where
+   * those that it gained are known to be finished already.
+   */
+  void refinish() {
+    flags.maskOr(FINISHED);
   }
 
 private:
   /**
-   * Deallocate the object. It should have previously been destroyed.
+   * Reset the header of a newly copied object.
+   *
+   * @param label The new label, or null for the root label.
    */
-  void deallocate() {
-    assert(sharedCount.load() == 0u);
-    assert(memoCount.load() == 0u);
-    libbirch::deallocate(this, size, tid);
+  void reset(Label* label) {
+    new (&this->label) decltype(this->label)(label);
+    sharedCount.storeRelaxed(INITIAL_SHARED);
+    #ifndef ENABLE_COMPACT_HEADER
+    localCount.storeRelaxed(0);
+    memoCount.storeRelaxed(1u);
+    tid = get_thread_num();
+    #endif
+    flags.storeRelaxed(INITIAL_FLAGS);
   }
 
   /**
-   * Label of the object.
+   * Deallocate the object. It should have previously been destroyed.
    */
-  LabelPtr label;
+  void deallocate() {
+    assert(numShared() == 0u);
+    assert(numMemo() == 0u);
+    libbirch::deallocate(this, size, owner());
+  }
+
+  union {
+    /**
+     * Label of the object, while it is not destroyed.
+     */
+    LabelPtr label;
+
+    /**
+     * Size of the object, once it is destroyed, for deallocate(). This is
+     * obtained with a virtual function call upon destruction, and shares
+     * storage with the label, which is then no longer needed, rather than
+     * occupying its own field. This keeps the header to 32 bytes (on 64-bit
+     * platforms): the virtual table pointer, the label, the three counts,
+     * and the thread id and flags together. With ENABLE_COMPACT_HEADER it
+     * is 24 bytes: the virtual table pointer, the label, the shared count,
+     * and the memo count and flags together.
+     */
+    unsigned size;
+  };
 
   /**
-   * Shared count.
+   * Shared part of the shared count, updated by threads other than the
+   * owning thread. This is offset by COUNT_OFFSET, as it may be negative,
+   * with the MERGED bit set once the local part has been merged into it.
    */
   Atomic<unsigned> sharedCount;
 
+  #ifndef ENABLE_COMPACT_HEADER
   /**
-   * Memo count, or, if the shared count is nonzero, one plus the memo count.
+   * Local part of the shared count, updated only by the owning thread (that
+   * with id `tid`). It is atomic only so that other threads may read it;
+   * updates use plain loads and stores rather than atomic read-modify-write
+   * operations.
    */
-  Atomic<unsigned> memoCount;
+  Atomic<int> localCount;
 
   /**
-   * Size of the object. This is initially set to zero. Upon destruction, it
-   * is set to the correct size with a virtual function call.
+   * Memo count, or, if the shared count is nonzero, one plus the memo count.
    */
-  unsigned size;
+  Atomic<unsigned> memoCount;
 
   /**
    * Id of the thread associated with the object. This is set immediately
@@ -413,6 +641,7 @@ private:
    * pool after use, even when returned by a different thread.
    */
   int16_t tid;
+  #endif
 
   /**
    * Bitfield containing flags. These are, from least to most significant
@@ -435,6 +664,10 @@ private:
    * ---these used for cycle collection as in @ref Bacon2001
    * "Bacon & Rajan (2001)".
    *
+   * Then follow *destroyed*, *merge queued*, the latter indicating that
+   * the object awaits a merge of its shared count by the owning thread, and
+   * *profiled*, indicating that the object is counted in the heap profile.
+   *
    * The second group of flags take the place of the colors described in
    * @ref Bacon2001 "Bacon & Rajan (2001)". The reason is to ensure that both
    * the bookkeeping required during normal execution can be multithreaded,
@@ -456,8 +689,15 @@ private:
    * otherwise exist during the scan operation, when coloring an object white
    * (eligible for collection) then later recoloring it black (reachable); the
    * sequencing of this coloring can become problematic with multiple threads.
+   *
+   * With ENABLE_COMPACT_HEADER, the memo count is kept in the bits above the
+   * flags (@see MEMO_SHIFT), as there is no separate field for it.
    */
+  #ifdef ENABLE_COMPACT_HEADER
+  Atomic<unsigned> flags;
+  #else
   Atomic<uint16_t> flags;
+  #endif
 
   /**
    * Flags.
@@ -472,8 +712,122 @@ private:
     SCANNED = (1u << 6u),
     REACHED = (1u << 7u),
     COLLECTED = (1u << 8u),
-    DESTROYED = (1u << 9u)
+    DESTROYED = (1u << 9u),
+    MERGE_QUEUED = (1u << 10u),
+    PROFILED = (1u << 11u)
+  };
+
+  /**
+   * Constants for the shared part of the shared count.
+   */
+  enum : unsigned {
+    /**
+     * Bit that indicates that the local part has been merged into the
+     * shared part.
+     */
+    MERGED = (1u << 31u),
+
+    /**
+     * Offset, allowing the shared part to be negative.
+     */
+    COUNT_OFFSET = (1u << 30u),
+
+    /**
+     * Initial value of the shared part. With ENABLE_COMPACT_HEADER there is
+     * no local part, and objects start merged, as for unbias().
+     */
+    #ifdef ENABLE_COMPACT_HEADER
+    INITIAL_SHARED = MERGED|COUNT_OFFSET
+    #else
+    INITIAL_SHARED = COUNT_OFFSET
+    #endif
+  };
+
+  /**
+   * Constants for the memo count, with ENABLE_COMPACT_HEADER.
+   */
+  enum : unsigned {
+    /**
+     * Position of the memo count in the flags. This leaves 20 bits for the
+     * memo count, so that an object may be a key in the memos of up to
+     * about a million labels at once.
+     */
+    MEMO_SHIFT = 12u,
+
+    /**
+     * One in the memo count.
+     */
+    MEMO_ONE = (1u << MEMO_SHIFT),
+
+    /**
+     * Initial value of the flags: none set, with a memo count of one for
+     * ENABLE_COMPACT_HEADER.
+     */
+    #ifdef ENABLE_COMPACT_HEADER
+    INITIAL_FLAGS = MEMO_ONE
+    #else
+    INITIAL_FLAGS = 0u
+    #endif
   };
+  static_assert(unsigned(PROFILED) < MEMO_ONE, "flags overlap memo count");
+
+  /**
+   * Extract the shared part of the shared count, as a signed value.
+   */
+  static int count(const unsigned shared) {
+    return int(shared & ~MERGED) - int(COUNT_OFFSET);
+  }
+
+  /**
+   * Should the current thread update the local part of the shared count?
+   * This is the case if it is the owning thread, and that thread has not yet
+   * merged the local part into the shared part.
+   */
+  bool isBiased() const {
+    #ifdef ENABLE_COMPACT_HEADER
+    return false;
+    #else
+    return tid == get_thread_num() && !(sharedCount.loadRelaxed() & MERGED);
+    #endif
+  }
+
+  /**
+   * Local part of the shared count. This is always zero with
+   * ENABLE_COMPACT_HEADER.
+   */
+  int local() const {
+    #ifdef ENABLE_COMPACT_HEADER
+    return 0;
+    #else
+    return localCount.loadRelaxed();
+    #endif
+  }
+
+  /**
+   * Set the local part of the shared count. Must only be called by the
+   * owning thread while biased.
+   */
+  void setLocal(const int local) {
+    #ifdef ENABLE_COMPACT_HEADER
+    assert(local == 0);
+    #else
+    localCount.storeRelaxed(local);
+    #endif
+  }
+
+  /**
+   * Id of the thread associated with the object. With ENABLE_COMPACT_HEADER
+   * this is not kept; the objects are never biased, and deallocate() takes
+   * the owning thread from the chunk of the allocation instead, so the
+   * current thread is returned.
+   */
+  int owner() const {
+    #ifdef ENABLE_COMPACT_HEADER
+    return get_thread_num();
+    #else
+    return tid;
+    #endif
+  }
 
 public:
   /**
@@ -531,6 +885,18 @@ public:
    */
   virtual void collect_() = 0;
 
+  /**
+   * Called internally by EagerMap::discover() to find the objects
+   * referenced by member variables.
+   */
+  virtual void discover_(const Discoverer& v) = 0;
+
+  /**
+   * Called internally by EagerMap::copy() to fix member variables after a
+   * bitwise copy.
+   */
+  virtual void copyEager_(const EagerCopier& v) = 0;
+
   /**
    * Accept a visitor across member variables.
    */
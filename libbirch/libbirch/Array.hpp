@@ -8,11 +8,15 @@
 #include "libbirch/type.hpp"
 #include "libbirch/Shape.hpp"
 #include "libbirch/Buffer.hpp"
+#include "libbirch/SmallBuffer.hpp"
 #include "libbirch/Iterator.hpp"
 #include "libbirch/Eigen.hpp"
 #include "libbirch/ReadersWriterLock.hpp"
+#include "libbirch/Rooter.hpp"
 
 namespace libbirch {
+template<class T, int64_t... Lengths> class StaticArray;
+
 /**
  * Array.
  *
@@ -22,12 +26,14 @@ namespace libbirch {
 template<class T, class F>
 class Array {
   template<class U, class G> friend class Array;
+  template<class U, int64_t... Lengths> friend class StaticArray;
 public:
   using this_type = Array<T,F>;
   using value_type = T;
   using shape_type = F;
   using eigen_type = typename eigen_type<this_type>::type;
   using eigen_stride_type = typename eigen_stride_type<this_type>::type;
+  using eigen_aligned_type = typename eigen_aligned_type<this_type>::type;
 
   /**
    * Constructor.
@@ -144,19 +150,31 @@ public:
   }
 
   /**
-   * Copy constructor. For value types, this uses a copy-on-write facility.
+   * Copy constructor. For non-views, this uses a copy-on-write facility,
+   * except for small arrays, which are copied immediately (@see
+   * SmallBuffer).
+   *
+   * For arrays of pointers, the elements are shared until one of the arrays
+   * is written. A read through an element may update its pointer in place,
+   * but only to the object that any other copy of the element would be
+   * updated to, as the label is the same, so this is safe. Objects that are
+   * to be frozen stop sharing their arrays beforehand (@see Finisher).
    */
   Array(const Array<T,F>& o) :
       shape(o.shape),
       buffer(o.buffer),
       offset(o.offset),
       isView(false) {
-    if (o.buffer) {
-      if (!o.isView && is_value<T>::value) {
-        /* copy on write for non-views of value types */
+    if (o.isSmall()) {
+      offset = 0;
+      allocate();
+      uninitialized_copy(o);
+    } else if (o.buffer) {
+      if (!o.isView) {
+        /* copy on write for non-views */
         buffer->incUsage();
       } else {
-        /* immediate copy for others */
+        /* immediate copy for views */
         buffer = nullptr;
         offset = 0;
         allocate();
@@ -199,7 +217,7 @@ public:
         auto bytes = Buffer<T>::size(volume());
         assert(bytes > 0u);
 	      void* src = buf();
-        buffer = new (libbirch::allocate(bytes)) Buffer<T>();
+        buffer = new (libbirch::allocate(bytes)) Buffer<T>(volume());
         offset = 0;
         void* dst = buf();
         std::memcpy(dst, src, sizeof(T)*volume());
@@ -220,8 +238,11 @@ public:
   template<class Visitor>
   void accept_(const Visitor& v) {
     if (!is_value<T>::value) {
-      auto iter = begin();
-      auto last = end();
+      /* the buffer may be shared, as during cycle collection, so iterate
+       * without the check of begin() */
+      const Array<T,F>& self = *this;
+      auto iter = self.begin();
+      auto last = self.end();
       for (; iter != last; ++iter) {
         v.visit(*iter);
       }
@@ -280,7 +301,7 @@ public:
   template<class V, class U, std::enable_if_t<V::rangeCount() != 0,int> = 0>
   auto set(const V& slice, const U& value) {
     pinWrite();
-    Array<T,decltype(shape(slice))> o(shape(slice), buffer, offset +
+    Array<T,decltype(shape(slice))> o(shape(slice), *this,
         shape.serial(slice));
     o = value;
     unpin();
@@ -297,7 +318,7 @@ public:
 
   template<class V, std::enable_if_t<V::rangeCount() != 0,int> = 0>
   auto get(const V& slice) const {
-    return Array<T,decltype(shape(slice))>(shape(slice), buffer, offset +
+    return Array<T,decltype(shape(slice))>(shape(slice), *this,
         shape.serial(slice));
   }
 
@@ -346,13 +367,13 @@ public:
   template<class V, std::enable_if_t<V::rangeCount() != 0,int> = 0>
   auto operator()(const V& slice) {
     assert(!isShared());
-    return Array<T,decltype(shape(slice))>(shape(slice),
-        buffer, offset + shape.serial(slice));
+    return Array<T,decltype(shape(slice))>(shape(slice), *this,
+        shape.serial(slice));
   }
   template<class V, std::enable_if_t<V::rangeCount() != 0,int> = 0>
   auto operator()(const V& slice) const {
-    return Array<T,decltype(shape(slice))>(shape(slice),
-        buffer, offset + shape.serial(slice));
+    return Array<T,decltype(shape(slice))>(shape(slice), *this,
+        shape.serial(slice));
   }
   template<class V, std::enable_if_t<V::rangeCount() == 0,int> = 0>
   value_type& operator()(const V& slice) {
@@ -383,10 +404,13 @@ public:
 
   /**
    * Pin the buffer. This prevents substitution of the buffer by
-   * copy-on-write operations until unpinned.
+   * copy-on-write operations until unpinned. A view cannot substitute its
+   * buffer, so for a view this does nothing.
    */
   void pin() const {
-    const_cast<Array*>(this)->bufferLock.setRead();
+    if (!isView) {
+      const_cast<Array*>(this)->bufferLock.setRead();
+    }
   }
 
   /**
@@ -396,8 +420,9 @@ public:
    * contents of the buffer.
    */
   void pinWrite() {
-    assert(!isView);
-    if (isShared()) {
+    if (isView) {
+      //
+    } else if (isShared()) {
       bufferLock.setWrite();
       if (isShared()) {
         Array<T,F> tmp(shape, *this);
@@ -409,11 +434,28 @@ public:
     }
   }
 
+  /**
+   * Obtain a view of the whole array, through which elements may be written
+   * without pinning. Where many threads write disjoint
+   * elements, as in a parallel loop, each may obtain its own view, so that
+   * they do not contend for the lock of the array. As for pinWrite(), the
+   * buffer is first copied if shared. The caller is responsible for ensuring
+   * that the array is not resized, assigned or copied while the view is in
+   * use.
+   */
+  Array<T,F> view() {
+    pinWrite();
+    unpin();
+    return Array<T,F>(shape, *this, int64_t(0));
+  }
+
   /**
    * Unpin the buffer.
    */
   void unpin() const {
-    const_cast<Array*>(this)->bufferLock.unsetRead();
+    if (!isView) {
+      const_cast<Array*>(this)->bufferLock.unsetRead();
+    }
   }
 
   /**
@@ -432,6 +474,82 @@ public:
   }
   ///@}
 
+  /**
+   * @name Cycle collection
+   *
+   * A buffer of pointers may be shared by several arrays, so takes part in
+   * cycle collection as a node in its own right, with its usage count
+   * serving as its reference count (@see Buffer). Each operation visits the
+   * elements on the first visit to the buffer only.
+   */
+  ///@{
+  /**
+   * Mark.
+   *
+   * @param v Visitor for the elements.
+   */
+  template<class Visitor>
+  void mark(const Visitor& v) {
+    if (!is_value<T>::value && buffer) {
+      buffer->breakUsage();  // break the reference
+      if (buffer->mark()) {
+        accept_(v);
+      }
+    }
+  }
+
+  /**
+   * Scan.
+   *
+   * @param v Visitor for the elements if the buffer is not reachable.
+   * @param w Visitor for the elements if the buffer is reachable.
+   */
+  template<class Visitor1, class Visitor2>
+  void scan(const Visitor1& v, const Visitor2& w) {
+    if (!is_value<T>::value && buffer && buffer->scan()) {
+      if (buffer->numUsage() > 0u) {
+        if (buffer->reach()) {
+          accept_(w);
+        }
+      } else {
+        accept_(v);
+      }
+    }
+  }
+
+  /**
+   * Reach.
+   *
+   * @param v Visitor for the elements.
+   */
+  template<class Visitor>
+  void reach(const Visitor& v) {
+    if (!is_value<T>::value && buffer) {
+      buffer->restoreUsage();  // restore the broken reference
+      if (buffer->reach()) {
+        accept_(v);
+      }
+    }
+  }
+
+  /**
+   * Collect.
+   *
+   * @param v Visitor for the elements.
+   */
+  template<class Visitor>
+  void collect(const Visitor& v) {
+    if (!is_value<T>::value && buffer) {
+      /* unlike an object, the buffer is released as usual when the array is
+       * destroyed, so restore the broken reference for that */
+      buffer->restoreUsage();
+      if (buffer->collect()) {
+        accept_(v);
+      }
+    }
+  }
+  ///@}
+
   /**
    * @name Thread-safe resize
    */
@@ -442,6 +560,10 @@ public:
    *
    * @param i Position.
    * @param x Value.
+   *
+   * When the buffer is full it is replaced with one of twice the size, so
+   * that a sequence of insertions at the back, or at the front, takes
+   * amortized constant time per element.
    */
   void insert(const int64_t i, const T& x) {
     static_assert(F::count() == 1, "can only enlarge one-dimensional arrays");
@@ -449,19 +571,21 @@ public:
 
     lock();
     auto n = size();
-    auto s = F(n + 1);
-    if (!buffer || isShared()) {
-      Array<T,F> tmp(s, *this);
-      swap(tmp);
-    } else {
-      auto oldBytes = Buffer<T>::size(shape.volume());
-      auto newBytes = Buffer<T>::size(s.volume());
-      buffer = (Buffer<T>*)libbirch::reallocate(buffer, oldBytes,
-          buffer->tid, newBytes);
+    auto front = n > 0 && i == 0;
+    auto c = bufferCapacity();
+    if (c == 0 || isShared() || (front ? offset == 0 : offset + n == c)) {
+      /* for insertion at the front, leave the free space before the
+       * elements, otherwise after */
+      auto capacity = std::max(2*n, n + 1);
+      relocate(capacity, front ? capacity - n : 0);
     }
-    std::memmove((void*)(buf() + i + 1), (void*)(buf() + i), (n - i)*sizeof(T));
+    if (front) {
+      --offset;
+    } else if (i < n) {
+      std::memmove((void*)(buf() + i + 1), (void*)(buf() + i), (n - i)*sizeof(T));
+    }
+    shape = F(n + 1);  // before buf(), which needs the size for isSmall()
     new (buf() + i) T(x);
-    shape = s;
     unlock();
   }
 
@@ -471,6 +595,10 @@ public:
    *
    * @param i Position.
    * @param len Number of elements to erase.
+   *
+   * Erasing from the front leaves free space before the remaining elements,
+   * rather than moving them. The buffer is replaced with a smaller one once
+   * no more than a quarter of it is in use.
    */
   void erase(const int64_t i, const int64_t len = 1) {
     static_assert(F::count() == 1, "can only shrink one-dimensional arrays");
@@ -483,21 +611,39 @@ public:
     auto s = F(n - len);
     if (s.size() == 0) {
       release();
+      shape = s;
     } else {
       if (isShared()) {
-        Array<T,F> tmp(shape, *this);
-        swap(tmp);
+        relocate(n, 0);
       }
-      for (int j = i; j < i + len; ++j) {
+      for (auto j = i; j < i + len; ++j) {
         buf()[j].~T();
       }
-      std::memmove((void*)(buf() + i), (void*)(buf() + i + len), (n - len - i)*sizeof(T));
-      auto oldBytes = Buffer<T>::size(shape.volume());
-      auto newBytes = Buffer<T>::size(s.volume());
-      buffer = (Buffer<T>*)libbirch::reallocate(buffer, oldBytes,
-          buffer->tid, newBytes);
+      if (i == 0) {
+        offset += len;
+      } else {
+        std::memmove((void*)(buf() + i), (void*)(buf() + i + len), (n - len - i)*sizeof(T));
+      }
+      shape = s;
+      if (buffer && 4*s.volume() <= buffer->capacity) {
+        relocate(2*s.volume(), 0);
+      }
+    }
+    unlock();
+  }
+
+  /**
+   * For a one-dimensional array, release any memory allocated beyond its
+   * size.
+   */
+  void shrink() {
+    static_assert(F::count() == 1, "can only shrink one-dimensional arrays");
+    assert(!isView);
+
+    lock();
+    if (buffer && !isShared() && buffer->capacity > volume()) {
+      relocate(volume(), 0);
     }
-    shape = s;
     unlock();
   }
   ///@}
@@ -523,6 +669,35 @@ public:
         colStride()));
   }
 
+  /**
+   * Are the elements contiguous and aligned to cache lines, so that
+   * toEigenAligned() may be used? This is the case for an array that is not
+   * a view, and so is contiguous, when the buffer is aligned (@see
+   * Buffer::alignment()) and there are no free elements before the first
+   * (@see insert()).
+   */
+  bool isAligned() const {
+    return !isView && buffer && reinterpret_cast<uintptr_t>(buf()) % 64u == 0u;
+  }
+
+  /**
+   * As toEigen(), but for an array that isAligned(). The Eigen map has unit
+   * strides and known alignment, so that Eigen may use aligned vector
+   * instructions on it, which it cannot with the general strides of
+   * toEigen().
+   */
+  template<IS_VALUE(T)>
+  auto toEigenAligned() {
+    assert(isAligned());
+    return eigen_aligned_type(buf(), rows(), cols());
+  }
+
+  template<IS_VALUE(T)>
+  auto toEigenAligned() const {
+    assert(isAligned());
+    return eigen_aligned_type(buf(), rows(), cols());
+  }
+
   /**
    * Construct from Eigen Matrix expression.
    */
@@ -533,7 +708,11 @@ public:
       offset(0),
       isView(false) {
     allocate();
-    toEigen() = o;
+    if (isAligned()) {
+      toEigenAligned() = o;
+    } else {
+      toEigen() = o;
+    }
   }
 
   /**
@@ -546,7 +725,11 @@ public:
       offset(0),
       isView(false) {
     allocate();
-    toEigen() = o;
+    if (isAligned()) {
+      toEigenAligned() = o;
+    } else {
+      toEigen() = o;
+    }
   }
 
   /**
@@ -559,7 +742,11 @@ public:
       offset(0),
       isView(false) {
     allocate();
-    toEigen() = o;
+    if (isAligned()) {
+      toEigenAligned() = o;
+    } else {
+      toEigen() = o;
+    }
   }
 
   /**
@@ -611,20 +798,61 @@ private:
 
   /**
    * Constructor for views.
+   *
+   * @param shape Shape of the view.
+   * @param o Array to view.
+   * @param serial Serial index in @p o of the first element of the view.
    */
-  Array(const F& shape, Buffer<T>* buffer, int64_t offset) :
+  template<class G>
+  Array(const F& shape, const Array<T,G>& o, const int64_t serial) :
       shape(shape),
-      buffer(buffer),
-      offset(offset),
+      buffer(o.buffer),
+      offset(o.offset + serial),
       isView(true) {
-    //
+    if (!buffer) {
+      /* elements are in the small buffer of o, or o is empty */
+      small.view(o.buf());
+      offset = serial;
+    }
   }
 
   /**
-   * Raw pointer to underlying buffer.
+   * Raw pointer to underlying buffer, or null if there is no buffer.
    */
   T* buf() const {
-    return buffer->buf() + offset;
+    auto self = const_cast<Array*>(this);
+    if (buffer) {
+      return buffer->buf() + offset;
+    } else if (isView) {
+      auto elements = self->small.viewed();
+      return elements ? elements + offset : nullptr;
+    } else if (isSmall()) {
+      return self->small.buf() + offset;
+    } else {
+      return nullptr;
+    }
+  }
+
+  /**
+   * Number of elements for which the underlying buffer, which may be the
+   * small buffer, has room, or zero if there is no buffer.
+   */
+  int64_t bufferCapacity() const {
+    if (buffer) {
+      return buffer->capacity;
+    } else if (isSmall()) {
+      return SmallBuffer<T>::capacity;
+    } else {
+      return 0;
+    }
+  }
+
+  /**
+   * Are the elements in the small buffer? This is the case for an array that
+   * is not a view, has elements, but has not allocated a buffer.
+   */
+  bool isSmall() const {
+    return !isView && !buffer && volume() > 0;
   }
 
   /**
@@ -640,6 +868,9 @@ private:
   void swap(Array<T,F>& o) {
     assert(!isView);
     assert(!o.isView);
+    if (isSmall() || o.isSmall()) {
+      std::swap(small, o.small);
+    }
     std::swap(buffer, o.buffer);
     std::swap(shape, o.shape);
     std::swap(offset, o.offset);
@@ -650,17 +881,94 @@ private:
    */
   void allocate() {
     assert(!buffer);
-    auto bytes = Buffer<T>::size(volume());
-    if (bytes > 0u) {
-      buffer = new (libbirch::allocate(bytes)) Buffer<T>();
+    auto n = volume();
+    if (0 < n && n <= SmallBuffer<T>::capacity) {
+      offset = 0;  // elements go in the small buffer
+    } else if (n > 0) {
+      buffer = new (libbirch::allocate(Buffer<T>::size(n))) Buffer<T>(n);
       offset = 0;
     }
   }
 
+  /**
+   * For a one-dimensional array, move the elements to a new buffer. If the
+   * current buffer is shared, the elements are copied, otherwise they are
+   * moved bitwise. If the capacity is small enough, the new buffer is the
+   * small buffer.
+   *
+   * @param capacity Capacity of the new buffer.
+   * @param front Number of free elements to leave before the elements in the
+   * new buffer.
+   */
+  void relocate(const int64_t capacity, const int64_t front) {
+    assert(!isView);
+    assert(capacity >= front + volume());
+
+    if (SmallBuffer<T>::capacity > 0 && capacity <= SmallBuffer<T>::capacity) {
+      if (isSmall()) {
+        std::memmove((void*)(small.buf() + front), (void*)buf(),
+            volume()*sizeof(T));
+      } else {
+        auto dst = small.buf() + front;
+        if (isShared()) {
+          std::uninitialized_copy(buf(), buf() + volume(), dst);
+          release();
+        } else if (buffer) {
+          std::memcpy((void*)dst, (void*)buf(), volume()*sizeof(T));
+          libbirch::deallocate(buffer, Buffer<T>::size(buffer->capacity),
+              buffer->tid);
+          buffer = nullptr;
+        }
+      }
+      offset = front;
+      return;
+    }
+
+    auto bytes = Buffer<T>::size(capacity);
+    if (buffer && !isShared() && front == offset &&
+        Buffer<T>::alignment(capacity) ==
+        Buffer<T>::alignment(buffer->capacity)) {
+      /* elements stay in place relative to the buffer, so reallocate; this
+       * requires the same alignment, so that the padding before the
+       * elements in the old buffer is within the size of the new buffer */
+      auto o = (Buffer<T>*)libbirch::reallocate(buffer,
+          Buffer<T>::size(buffer->capacity), buffer->tid, bytes);
+      if (o != buffer) {
+        o->tid = get_thread_num();
+      }
+      o->realign(capacity);
+      buffer = o;
+      return;
+    }
+    auto o = new (libbirch::allocate(bytes)) Buffer<T>(capacity);
+    auto dst = o->buf() + front;
+    if (SmallBuffer<T>::capacity > 0 && isSmall()) {
+      std::memcpy((void*)dst, (void*)buf(), volume()*sizeof(T));
+    } else if (buffer) {
+      if (isShared()) {
+        std::uninitialized_copy(buf(), buf() + volume(), dst);
+        release();
+      } else {
+        std::memcpy((void*)dst, (void*)buf(), volume()*sizeof(T));
+        libbirch::deallocate(buffer, Buffer<T>::size(buffer->capacity),
+            buffer->tid);
+      }
+    }
+    buffer = o;
+    offset = front;
+  }
+
   /**
    * Deallocate memory of array.
    */
   void release() {
+    if (!isView && buffer && !is_value<T>::value &&
+        buffer->numUsage() > 1u && buffer->isMarkedShared()) {
+      /* other arrays continue to share the buffer, but for this one the
+       * references held by the elements are released, and so their referents
+       * are possible roots of cycles */
+      accept_(Rooter());
+    }
     if (!isView && buffer && buffer->decUsage() == 0u) {
       if (!is_value<T>::value) {
         ///@todo in C++17 can use std::destroy()
@@ -670,7 +978,7 @@ private:
           iter->~T();
         }
       }
-      size_t bytes = Buffer<T>::size(volume());
+      size_t bytes = Buffer<T>::size(buffer->capacity);
       libbirch::deallocate(buffer, bytes, buffer->tid);
     }
     buffer = nullptr;
@@ -734,10 +1042,17 @@ private:
   Buffer<T>* buffer;
 
   /**
-   * Offset into the buffer. This should be zero when isView is false.
+   * Offset into the buffer. When isView is false, this is the number of free
+   * elements before the first, left by insert() and erase().
    */
   int64_t offset;
 
+  /**
+   * Small buffer, used instead of allocating a buffer when the elements fit
+   * (@see isSmall()).
+   */
+  SmallBuffer<T> small;
+
   /**
    * Is this a view of another array? A view has stricter assignment
    * semantics, as it cannot be resized or moved.
@@ -18,12 +18,22 @@
  *
  * The alternative implementation use std::atomic.
  *
+ * The default memory ordering of all operations is sequentially consistent.
+ * Variants of the most frequent operations with weaker orderings are also
+ * provided, suffixed with the ordering (e.g. loadAcquire(),
+ * incrementRelaxed()). These map to the corresponding `std::memory_order`
+ * for std::atomic, and to the corresponding clauses of OpenMP 5.0 for
+ * OpenMP, or to sequentially consistent operations for earlier versions of
+ * OpenMP (see LIBBIRCH_OMP_RELAXED).
+ *
  * Atomic provides the default constructor, copy and move constructors, copy
  * and move assignment operators, in order to be trivially copyable and so
  * a mappable type for the purposes of OpenMP. These constructors and
  * operators *do not* behave atomically, however.
  */
-#ifndef HAVE_OMP_H
+#ifdef LIBBIRCH_ATOMIC_OPENMP
+/* already set, e.g. on the command line */
+#elif !defined(HAVE_OMP_H)
 /* this looks like it's backwards, but when OpenMP is disabled, enabling the
  * OpenMP implementation has the effect of replacing atomic operations with
  * regular operations, which is faster */
@@ -39,6 +49,28 @@
 #include <atomic>
 #endif
 
+/**
+ * @def LIBBIRCH_OMP_RELAXED
+ * @def LIBBIRCH_OMP_ACQUIRE
+ * @def LIBBIRCH_OMP_RELEASE
+ * @def LIBBIRCH_OMP_ACQ_REL
+ *
+ * Memory-order clauses for OpenMP atomics. The weaker orderings are clauses
+ * of OpenMP 5.0; for earlier versions these fall back to `seq_cst`, which is
+ * stronger than required, but correct.
+ */
+#if defined(_OPENMP) && _OPENMP >= 201811
+#define LIBBIRCH_OMP_RELAXED relaxed
+#define LIBBIRCH_OMP_ACQUIRE acquire
+#define LIBBIRCH_OMP_RELEASE release
+#define LIBBIRCH_OMP_ACQ_REL acq_rel
+#else
+#define LIBBIRCH_OMP_RELAXED seq_cst
+#define LIBBIRCH_OMP_ACQUIRE seq_cst
+#define LIBBIRCH_OMP_RELEASE seq_cst
+#define LIBBIRCH_OMP_ACQ_REL seq_cst
+#endif
+
 namespace libbirch {
 /**
  * Atomic value.
@@ -78,6 +110,34 @@ public:
     return value;
   }
 
+  /**
+   * Load the value, atomically, with relaxed memory ordering.
+   */
+  T loadRelaxed() const {
+    T value;
+    #if LIBBIRCH_ATOMIC_OPENMP
+    #pragma omp atomic read LIBBIRCH_OMP_RELAXED
+    value = this->value;
+    #else
+    value = this->value.load(std::memory_order_relaxed);
+    #endif
+    return value;
+  }
+
+  /**
+   * Load the value, atomically, with acquire memory ordering.
+   */
+  T loadAcquire() const {
+    T value;
+    #if LIBBIRCH_ATOMIC_OPENMP
+    #pragma omp atomic read LIBBIRCH_OMP_ACQUIRE
+    value = this->value;
+    #else
+    value = this->value.load(std::memory_order_acquire);
+    #endif
+    return value;
+  }
+
   /**
    * Store the value, atomically.
    */
@@ -90,6 +150,30 @@ public:
     #endif
   }
 
+  /**
+   * Store the value, atomically, with relaxed memory ordering.
+   */
+  void storeRelaxed(const T& value) {
+    #if LIBBIRCH_ATOMIC_OPENMP
+    #pragma omp atomic write LIBBIRCH_OMP_RELAXED
+    this->value = value;
+    #else
+    this->value.store(value, std::memory_order_relaxed);
+    #endif
+  }
+
+  /**
+   * Store the value, atomically, with release memory ordering.
+   */
+  void storeRelease(const T& value) {
+    #if LIBBIRCH_ATOMIC_OPENMP
+    #pragma omp atomic write LIBBIRCH_OMP_RELEASE
+    this->value = value;
+    #else
+    this->value.store(value, std::memory_order_release);
+    #endif
+  }
+
   /**
    * Exchange the value with another, atomically.
    *
@@ -111,6 +195,28 @@ public:
     return old;
   }
 
+  /**
+   * Exchange the value with another, atomically, with acquire memory
+   * ordering.
+   *
+   * @param value New value.
+   *
+   * @return Old value.
+   */
+  T exchangeAcquire(const T& value) {
+    T old;
+    #if LIBBIRCH_ATOMIC_OPENMP
+    #pragma omp atomic capture LIBBIRCH_OMP_ACQUIRE
+    {
+      old = this->value;
+      this->value = value;
+    }
+    #else
+    old = this->value.exchange(value, std::memory_order_acquire);
+    #endif
+    return old;
+  }
+
   /**
    * Apply a mask, with bitwise `and`, and return the previous value,
    * atomically.
@@ -190,6 +296,19 @@ public:
     ++value;
   }
 
+  /**
+   * Increment the value by one, atomically, with relaxed memory ordering,
+   * but without capturing the current value.
+   */
+  void incrementRelaxed() {
+    #if LIBBIRCH_ATOMIC_OPENMP
+    #pragma omp atomic update LIBBIRCH_OMP_RELAXED
+    ++value;
+    #else
+    value.fetch_add(1, std::memory_order_relaxed);
+    #endif
+  }
+
   /**
    * Decrement the value by one, atomically, but without capturing the
    * current value.
@@ -201,6 +320,47 @@ public:
     --value;
   }
 
+  /**
+   * Decrement the value by one, atomically, with relaxed memory ordering,
+   * but without capturing the current value.
+   */
+  void decrementRelaxed() {
+    #if LIBBIRCH_ATOMIC_OPENMP
+    #pragma omp atomic update LIBBIRCH_OMP_RELAXED
+    --value;
+    #else
+    value.fetch_sub(1, std::memory_order_relaxed);
+    #endif
+  }
+
+  /**
+   * Decrement the value by one, atomically, with release memory ordering,
+   * but without capturing the current value.
+   */
+  void decrementRelease() {
+    #if LIBBIRCH_ATOMIC_OPENMP
+    #pragma omp atomic update LIBBIRCH_OMP_RELEASE
+    --value;
+    #else
+    value.fetch_sub(1, std::memory_order_release);
+    #endif
+  }
+
+  /**
+   * Decrement the value by one, atomically, with acquire-release memory
+   * ordering, and return the new value.
+   */
+  T decrementAcqRel() {
+    T value;
+    #if LIBBIRCH_ATOMIC_OPENMP
+    #pragma omp atomic capture LIBBIRCH_OMP_ACQ_REL
+    value = --this->value;
+    #else
+    value = this->value.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    #endif
+    return value;
+  }
+
   /**
    * Add to the value, atomically, but without capturing the current value.
    */
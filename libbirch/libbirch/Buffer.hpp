@@ -13,7 +13,9 @@ namespace libbirch {
  * between arrays with copy-on-write semantics, and overallocated to contain
  * bookkeeping variables, as well as the contents of the buffer itself, in
  * the one allocation. They do not inherit from Countable, as their reference
- * counting semantics are simpler.
+ * counting semantics are simpler. As a buffer of pointers may be shared, it
+ * takes part in cycle collection as a node in its own right, with the usage
+ * count serving as its reference count.
  *
  * @ingroup libbirch
  */
@@ -27,8 +29,20 @@ public:
 
   /**
    * Constructor.
+   *
+   * @param capacity Number of elements for which the buffer has room.
+   */
+  Buffer(const int64_t capacity);
+
+  /**
+   * Update the capacity after the buffer has been reallocated. The buffer
+   * may have moved, or crossed the size at which its elements are aligned
+   * to cache lines, so the elements are moved within it if necessary to
+   * restore their alignment.
+   *
+   * @param capacity Number of elements for which the buffer has room.
    */
-  Buffer();
+  void realign(const int64_t capacity);
 
   /**
    * Increment the usage count.
@@ -36,7 +50,10 @@ public:
   void incUsage();
 
   /**
-   * Decrement the usage count.
+   * Decrement the usage count. Once only one array uses the buffer, the
+   * flag of isMarkedShared() is cleared, as there is then no other array
+   * whose release must register the referents of the elements as possible
+   * roots.
    *
    * @return Use count.
    */
@@ -47,6 +64,57 @@ public:
    */
   unsigned numUsage() const;
 
+  /**
+   * Decrement the usage count to break a reference during cycle collection.
+   */
+  void breakUsage();
+
+  /**
+   * Has the buffer been marked during cycle collection while shared? If so,
+   * marking may have relied on a reference from an array that was not
+   * marked, and so consumed the possible roots of cycles that include the
+   * buffer. When such an array releases the buffer, the referents of the
+   * elements should be registered as possible roots again, as they would
+   * have been had the buffer not been shared.
+   */
+  bool isMarkedShared() const;
+
+  /**
+   * Increment the usage count to restore a reference broken with
+   * breakUsage().
+   */
+  void restoreUsage();
+
+  /**
+   * Mark the buffer, as for Any::mark().
+   *
+   * @return Is this the first visit, so that the elements should be marked?
+   */
+  bool mark();
+
+  /**
+   * Scan the buffer, as for Any::scan().
+   *
+   * @return Is this the first visit, so that the elements should be scanned
+   * or reached, according to the usage count?
+   */
+  bool scan();
+
+  /**
+   * Reach the buffer, as for Any::reach().
+   *
+   * @return Is this the first visit, so that the elements should be reached?
+   */
+  bool reach();
+
+  /**
+   * Collect the buffer, as for Any::collect().
+   *
+   * @return Is this the first visit to an unreached buffer, so that the
+   * elements should be collected?
+   */
+  bool collect();
+
   /**
    * Get the start of the buffer.
    */
@@ -63,6 +131,22 @@ public:
    */
   static size_t size(const int64_t n);
 
+  /**
+   * Alignment of the elements of a buffer of this type with @p n elements.
+   * Buffers of arithmetic type with room for at least a cache line of
+   * elements are aligned to cache lines, so that Eigen may use aligned
+   * vector instructions on them (@see Array::isAligned()). Others have the
+   * natural alignment of the type, as smaller buffers are common, and would
+   * gain little from the padding.
+   */
+  static size_t alignment(const int64_t n);
+
+  /**
+   * Number of elements for which the buffer has room. This may exceed the
+   * number of elements in use, to amortize the cost of growing an array.
+   */
+  int64_t capacity;
+
   /**
    * Id of the thread that allocated the buffer.
    */
@@ -75,47 +159,159 @@ private:
   Atomic<unsigned> useCount;
 
   /**
-   * First element in the buffer. Taking the address of this gives a pointer
-   * to the start of the overallocated buffer.
+   * Bitfield of flags for cycle collection, as for Any.
+   */
+  Atomic<uint16_t> flags;
+
+  /**
+   * Flags.
+   */
+  enum Flag : uint16_t {
+    MARKED = (1u << 0u),
+    SCANNED = (1u << 1u),
+    REACHED = (1u << 2u),
+    COLLECTED = (1u << 3u),
+    MARKED_SHARED = (1u << 4u)
+  };
+
+  /**
+   * Number of bytes of padding between first and the first element, to
+   * align the elements.
+   */
+  uint16_t pad;
+
+  /**
+   * First element in the buffer, before padding. Taking the address of this
+   * gives a pointer to the start of the overallocated buffer.
    */
   alignas(T) char first;
+
+  /**
+   * Compute the padding required to align the elements of a buffer with
+   * @p n elements.
+   */
+  uint16_t padding(const int64_t n) const;
 };
 }
 
 template<class T>
-libbirch::Buffer<T>::Buffer() :
+libbirch::Buffer<T>::Buffer(const int64_t capacity) :
+    capacity(capacity),
     tid(get_thread_num()),
-    useCount(1) {
+    useCount(1),
+    flags(0),
+    pad(padding(capacity)) {
   //
 }
 
+template<class T>
+void libbirch::Buffer<T>::realign(const int64_t capacity) {
+  auto old = pad;
+  pad = padding(capacity);
+  if (pad != old) {
+    std::memmove(&first + pad, &first + old,
+        sizeof(T)*std::min(this->capacity, capacity));
+  }
+  this->capacity = capacity;
+}
+
 template<class T>
 void libbirch::Buffer<T>::incUsage() {
-  useCount.increment();
+  useCount.incrementRelaxed();
 }
 
 template<class T>
 unsigned libbirch::Buffer<T>::decUsage() {
-  assert(useCount.load() > 0);
-  return --useCount;
+  assert(useCount.loadRelaxed() > 0);
+  auto n = useCount.decrementAcqRel();
+  if (n == 1u && (flags.loadRelaxed() & MARKED_SHARED)) {
+    flags.maskAnd(~MARKED_SHARED);
+  }
+  return n;
 }
 
 template<class T>
 unsigned libbirch::Buffer<T>::numUsage() const {
-  return useCount.load();
+  return useCount.loadAcquire();
+}
+
+template<class T>
+void libbirch::Buffer<T>::breakUsage() {
+  if (useCount.loadRelaxed() > 1u) {
+    flags.maskOr(MARKED_SHARED);
+  }
+  useCount.decrementRelease();
+}
+
+template<class T>
+bool libbirch::Buffer<T>::isMarkedShared() const {
+  return flags.load() & MARKED_SHARED;
+}
+
+template<class T>
+void libbirch::Buffer<T>::restoreUsage() {
+  useCount.incrementRelaxed();
+}
+
+template<class T>
+bool libbirch::Buffer<T>::mark() {
+  if (!(flags.exchangeOr(MARKED) & MARKED)) {
+    flags.maskAnd(~(SCANNED|REACHED|COLLECTED));
+    return true;
+  }
+  return false;
+}
+
+template<class T>
+bool libbirch::Buffer<T>::scan() {
+  if (!(flags.exchangeOr(SCANNED) & SCANNED)) {
+    flags.maskAnd(~MARKED);  // unset for next time
+    return true;
+  }
+  return false;
+}
+
+template<class T>
+bool libbirch::Buffer<T>::reach() {
+  if (!(flags.exchangeOr(SCANNED) & SCANNED)) {
+    flags.maskAnd(~MARKED);  // unset for next time
+  }
+  return !(flags.exchangeOr(REACHED) & REACHED);
+}
+
+template<class T>
+bool libbirch::Buffer<T>::collect() {
+  auto old = flags.exchangeOr(COLLECTED);
+  return !(old & COLLECTED) && !(old & REACHED);
 }
 
 template<class T>
 T* libbirch::Buffer<T>::buf() {
-  return (T*)&first;
+  return (T*)(&first + pad);
 }
 
 template<class T>
 const T* libbirch::Buffer<T>::buf() const {
-  return (const T*)&first;
+  return (const T*)(&first + pad);
 }
 
 template<class T>
 size_t libbirch::Buffer<T>::size(const int64_t n) {
-  return n > 0 ? sizeof(T)*n + sizeof(Buffer<T>) : 0;
+  /* allocations are aligned to at least alignof(T), so this allows for the
+   * largest padding that can be required */
+  return n > 0 ? sizeof(T)*n + sizeof(Buffer<T>) + alignment(n) - alignof(T) :
+      0;
+}
+
+template<class T>
+size_t libbirch::Buffer<T>::alignment(const int64_t n) {
+  return std::is_arithmetic<T>::value && sizeof(T)*n >= 64u ? 64u :
+      alignof(T);
+}
+
+template<class T>
+uint16_t libbirch::Buffer<T>::padding(const int64_t n) const {
+  auto a = alignment(n);
+  auto p = reinterpret_cast<uintptr_t>(&first);
+  return uint16_t((a - p % a) % a);
 }
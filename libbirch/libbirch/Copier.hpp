@@ -7,6 +7,7 @@
 #include "libbirch/Array.hpp"
 #include "libbirch/Optional.hpp"
 #include "libbirch/Lazy.hpp"
+#include "libbirch/EagerMap.hpp"
 
 namespace libbirch {
 /**
@@ -105,27 +106,56 @@ private:
   Label* label;
 };
 
+/**
+ * Finish and freeze an object and its label, as the first step of a clone.
+ *
+ * @param ptr The object.
+ * @param label The label of the pointer to the object.
+ */
+template<class T>
+void finish_and_freeze(T* ptr, Label* label) {
+  /* objects may be reachable from several clones at once, so no thread may
+   * freeze while another finishes: finish only once no thread is freezing,
+   * and enter the freeze before exiting the finish, so that no thread starts
+   * finishing until all have frozen */
+  finish_lock.enter(freeze_lock);
+  ptr->finish(label);
+  label->finish(label);
+  freeze_lock.enter();
+  finish_lock.exit();
+
+  ptr->freeze();
+  label->freeze();
+  freeze_lock.exit();
+}
+
 /**
  * Clone an object via a pointer.
  *
  * @ingroup libbirch
  *
  * @param o The pointer.
+ *
+ * The copy is eager if no more objects than get_eager_clone_limit() are
+ * reachable from the object (@see EagerMap), otherwise lazy.
  */
 template<class P>
 auto clone(const Lazy<P>& o) {
+  using T = typename P::value_type;
   auto ptr = o.pull();
-  auto label = o.getLabel();
-
-  finish_lock.enter();
-  ptr->finish(label);
-  label->finish(label);
-  finish_lock.exit();
+  count_stat(&Stats::nclones);
+
+  /* copy eagerly if the object graph is small enough */
+  auto limit = get_eager_clone_limit();
+  if (limit > 0) {
+    EagerMap map(limit);
+    if (map.discover(ptr)) {
+      return Lazy<P>(static_cast<T*>(map.copy()));
+    }
+  }
 
-  freeze_lock.enter();
-  ptr->freeze();
-  label->freeze();
-  freeze_lock.exit();
+  auto label = o.getLabel();
+  finish_and_freeze(ptr, label);
 
   /* shared counts on labels are handled by Any, not Lazy; consequently we
    * need to complete the first copy in order to create a shared pointer to
@@ -135,4 +165,50 @@ auto clone(const Lazy<P>& o) {
   return Lazy<P>(newPtr, newLabel);
 }
 
+/**
+ * Clone an object via a pointer multiple times.
+ *
+ * @ingroup libbirch
+ *
+ * @param o The pointer.
+ * @param n Number of clones.
+ *
+ * @return Vector of @p n clones.
+ *
+ * This is equivalent to calling clone() @p n times, but finishes and freezes
+ * only once, so that the clones differ only in their labels (each a
+ * constant-time copy of the original label) and first copies. For eager
+ * copies, it finds the objects to copy only once.
+ */
+template<class P>
+auto clone_many(const Lazy<P>& o, const int64_t n) {
+  using T = typename P::value_type;
+  using F = Shape<Dimension<>,EmptyShape>;
+  auto ptr = o.pull();
+  count_stat(&Stats::nclones, n);
+
+  /* copy eagerly if the object graph is small enough, finding the objects
+   * only once for all copies */
+  auto limit = get_eager_clone_limit();
+  if (limit > 0) {
+    EagerMap map(limit);
+    if (map.discover(ptr)) {
+      auto l = [&](const int64_t i) {
+        return Lazy<P>(static_cast<T*>(map.copy()));
+      };
+      return Array<Lazy<P>,F>(l, F(Dimension<>(n, 1), EmptyShape()));
+    }
+  }
+
+  auto label = o.getLabel();
+  finish_and_freeze(ptr, label);
+
+  auto l = [=](const int64_t i) {
+    auto newLabel = new Label(*label);
+    auto newPtr = newLabel->copy(ptr);
+    return Lazy<P>(newPtr, newLabel);
+  };
+  return Array<Lazy<P>,F>(l, F(Dimension<>(n, 1), EmptyShape()));
+}
+
 }
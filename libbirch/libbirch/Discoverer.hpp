@@ -0,0 +1,98 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "libbirch/Tuple.hpp"
+#include "libbirch/Array.hpp"
+#include "libbirch/Optional.hpp"
+#include "libbirch/Lazy.hpp"
+#include "libbirch/EagerMap.hpp"
+
+namespace libbirch {
+/**
+ * Visitor for finding the objects reachable from an object, for an eager
+ * copy.
+ *
+ * @ingroup libbirch
+ */
+class Discoverer {
+public:
+  /**
+   * Constructor.
+   *
+   * @param map Map to which to add the objects found.
+   */
+  Discoverer(EagerMap* map) :
+      map(map) {
+    //
+  }
+
+  /**
+   * Visit list of variables.
+   *
+   * @param arg First variable.
+   * @param args... Remaining variables.
+   */
+  template<class Arg, class... Args>
+  void visit(Arg& arg, Args&... args) const {
+    visit(arg);
+    visit(args...);
+  }
+
+  /**
+   * Visit empty list of variables (base case).
+   */
+  void visit() const {
+    //
+  }
+
+  /**
+   * Visit a value.
+   */
+  template<class T, std::enable_if_t<is_value<T>::value,int> = 0>
+  void visit(T& arg) const {
+    //
+  }
+
+  /**
+   * Visit a tuple.
+   */
+  template<class Head, class... Tail>
+  void visit(Tuple<Head,Tail...>& o) const {
+    o.accept_(*this);
+  }
+
+  /**
+   * Visit an array.
+   */
+  template<class T, class F>
+  void visit(Array<T,F>& o) const {
+    o.accept_(*this);
+  }
+
+  /**
+   * Visit an optional.
+   */
+  template<class T>
+  void visit(Optional<T>& o) const {
+    o.accept_(*this);
+  }
+
+  /**
+   * Visit a lazy pointer.
+   */
+  template<class P>
+  void visit(Lazy<P>& o) const {
+    /* pull() updates the pointer to the object that it refers to through
+     * its label, which the bitwise copy then takes */
+    map->insert(o.pull());
+  }
+
+private:
+  /**
+   * Map to which to add the objects found.
+   */
+  EagerMap* map;
+};
+}
@@ -0,0 +1,63 @@
+/**
+ * @file
+ */
+#include "libbirch/EagerMap.hpp"
+
+#include "libbirch/Any.hpp"
+#include "libbirch/Discoverer.hpp"
+#include "libbirch/EagerCopier.hpp"
+
+/**
+ * Largest number of objects for which clone() makes an eager copy.
+ */
+static libbirch::Atomic<int> eager_clone_limit(0);
+
+libbirch::EagerMap::EagerMap(const int limit) :
+    limit(limit) {
+  //
+}
+
+bool libbirch::EagerMap::discover(Any* o) {
+  insert(o);
+  for (size_t i = 0; i < objects.size() && int(objects.size()) <= limit;
+      ++i) {
+    objects[i]->discover_(Discoverer(this));
+  }
+  return int(objects.size()) <= limit;
+}
+
+libbirch::Any* libbirch::EagerMap::copy() {
+  /* all objects are copied bitwise before any are fixed, as fixing a
+   * pointer increments the shared count of the copy that it refers to */
+  for (auto o : objects) {
+    copies[o] = o->copyEager();
+  }
+  for (auto o : objects) {
+    copies[o]->copyEager_(EagerCopier(this));
+  }
+  return copies[objects.front()];
+}
+
+void libbirch::EagerMap::insert(Any* o) {
+  if (o && copies.emplace(o, nullptr).second) {
+    objects.push_back(o);
+  }
+}
+
+libbirch::Any* libbirch::EagerMap::get(Any* o) const {
+  if (o) {
+    auto iter = copies.find(o);
+    assert(iter != copies.end() && iter->second);
+    return iter->second;
+  } else {
+    return nullptr;
+  }
+}
+
+void libbirch::set_eager_clone_limit(const int limit) {
+  eager_clone_limit.store(limit);
+}
+
+int libbirch::get_eager_clone_limit() {
+  return eager_clone_limit.loadRelaxed();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "libbirch/external.hpp"
+#include "libbirch/Allocator.hpp"
+
+namespace libbirch {
+class Any;
+
+/**
+ * Map of the objects of an eager copy to their copies.
+ *
+ * @ingroup libbirch
+ *
+ * An eager copy copies all objects reachable from an object at once, rather
+ * than lazily as they are written (@see Label). The source objects need not
+ * be finished or frozen, the copies are not memoized in a Label, and
+ * pointers between the copies need no later update. For small object graphs
+ * this is much cheaper than a lazy copy, but for large graphs that are
+ * mostly shared between clones, a lazy copy is cheaper. The map is therefore
+ * given a limit on the number of objects: discover() finds the objects
+ * reachable from an object, stopping if there are more than the limit, in
+ * which case the caller should make a lazy copy instead.
+ *
+ * Like a lazy copy, the object graph must not be modified while it is
+ * copied.
+ */
+class EagerMap {
+public:
+  /**
+   * Constructor.
+   *
+   * @param limit Largest number of objects to copy.
+   */
+  EagerMap(const int limit);
+
+  /**
+   * Find the objects reachable from an object.
+   *
+   * @param o The object.
+   *
+   * @return Are there no more than the limit of such objects?
+   */
+  bool discover(Any* o);
+
+  /**
+   * Copy the objects found by discover(). This may be called more than once
+   * to make multiple copies.
+   *
+   * @return Copy of the object given to discover().
+   */
+  Any* copy();
+
+  /**
+   * Add an object, if not already added, found while discovering.
+   */
+  void insert(Any* o);
+
+  /**
+   * Get the copy of an object.
+   */
+  Any* get(Any* o) const;
+
+private:
+  /**
+   * Objects found, in the order found.
+   */
+  std::vector<Any*,Allocator<Any*>> objects;
+
+  /**
+   * Map from objects to their copies.
+   */
+  std::unordered_map<Any*,Any*,std::hash<Any*>,std::equal_to<Any*>,
+      Allocator<std::pair<Any* const,Any*>>> copies;
+
+  /**
+   * Largest number of objects to copy.
+   */
+  int limit;
+};
+
+/**
+ * Set the largest number of objects for which clone() makes an eager copy
+ * rather than a lazy copy (@see EagerMap). The default is zero, for which
+ * clone() always makes a lazy copy.
+ *
+ * @ingroup libbirch
+ */
+void set_eager_clone_limit(const int limit);
+
+/**
+ * Get the largest number of objects for which clone() makes an eager copy
+ * rather than a lazy copy.
+ *
+ * @ingroup libbirch
+ */
+int get_eager_clone_limit();
+}
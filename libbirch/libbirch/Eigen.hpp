@@ -21,6 +21,20 @@ using EigenMatrix = Eigen::Matrix<Type,Eigen::Dynamic,Eigen::Dynamic,Eigen::RowM
 template<class Type>
 using EigenMatrixMap = Eigen::Map<EigenMatrix<Type>,Eigen::DontAlign,EigenMatrixStride>;
 
+template<class Type>
+using EigenVectorAlignedMap = Eigen::Map<EigenVector<Type>,Eigen::Aligned64>;
+template<class Type>
+using EigenMatrixAlignedMap = Eigen::Map<EigenMatrix<Type>,Eigen::Aligned64>;
+
+/*
+ * Fixed-size Eigen type for contiguous elements, with a column vector for a
+ * single column, as Eigen requires.
+ */
+template<class Type, int Rows, int Cols>
+using EigenFixedMap = Eigen::Map<Eigen::Matrix<Type,Rows,Cols,
+    (Cols == 1 && Rows != 1) ? Eigen::ColMajor : Eigen::RowMajor>,
+    Eigen::DontAlign>;
+
 /*
  * Eigen type for an array type.
  */
@@ -33,6 +47,18 @@ struct eigen_type {
     void>::type>::type;
 };
 
+/*
+ * Eigen type for an array type with contiguous and aligned elements.
+ */
+template<class ArrayType>
+struct eigen_aligned_type {
+  using type = typename std::conditional<ArrayType::shape_type::count() == 2,
+      EigenMatrixAlignedMap<typename ArrayType::value_type>,
+    typename std::conditional<ArrayType::shape_type::count() == 1,
+      EigenVectorAlignedMap<typename ArrayType::value_type>,
+    void>::type>::type;
+};
+
 template<class ArrayType>
 struct eigen_stride_type {
   using type = typename std::conditional<ArrayType::shape_type::count() == 2,
@@ -50,7 +76,7 @@ struct is_eigen_compatible {
   static const bool value =
       std::is_same<typename ArrayType::value_type,typename EigenType::value_type>::value &&
           ((ArrayType::shape_type::count() == 1 && EigenType::ColsAtCompileTime == 1) ||
-           (ArrayType::shape_type::count() == 2 && EigenType::ColsAtCompileTime == Eigen::Dynamic));
+           (ArrayType::shape_type::count() == 2 && EigenType::ColsAtCompileTime != 1));
 };
 
 template<class ArrayType, class EigenType>
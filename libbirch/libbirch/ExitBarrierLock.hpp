@@ -30,6 +30,18 @@ public:
    */
   void enter();
 
+  /**
+   * Enter the critical region once no thread is in another critical region,
+   * possibly blocking.
+   *
+   * @param o Lock of the other critical region.
+   *
+   * Threads that then enter the other critical region with a plain enter()
+   * before exiting this one will not proceed until all threads have exited
+   * this one, so the two critical regions are never occupied at once.
+   */
+  void enter(const ExitBarrierLock& o);
+
   /**
    * Exit the critical region, possibly blocking.
    */
@@ -52,6 +64,17 @@ inline void libbirch::ExitBarrierLock::enter() {
   ++ninternal;
 }
 
+inline void libbirch::ExitBarrierLock::enter(const ExitBarrierLock& o) {
+  while (true) {
+    while (o.ninternal.load() != 0);  // spin until the other region is empty
+    ++ninternal;
+    if (o.ninternal.load() == 0) {
+      return;
+    }
+    --ninternal;  // another thread entered the other region, back off
+  }
+}
+
 inline void libbirch::ExitBarrierLock::exit() {
   if (--ninternal == 0) {
     return;
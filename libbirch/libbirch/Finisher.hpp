@@ -69,6 +69,13 @@ public:
    */
   template<class T, class F>
   void visit(Array<T,F>& o) const {
+    if (!is_value<T>::value) {
+      /* the object is about to be frozen, so must not share elements with
+       * arrays that remain mutable, as reads through those may update the
+       * elements in place; copy the buffer if shared */
+      o.pinWrite();
+      o.unpin();
+    }
     o.accept_(*this);
   }
 
@@ -15,8 +15,14 @@ namespace libbirch {
  * @tparam F Shape type.
  */
 template<class T, class F = EmptyShape>
-class Iterator : public std::iterator<std::bidirectional_iterator_tag,T> {
+class Iterator {
 public:
+  using iterator_category = std::bidirectional_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
   /**
    * Constructor.
    *
@@ -3,6 +3,25 @@
  */
 #include "libbirch/Label.hpp"
 
+/**
+ * Count a lookup through a label, if the collection of runtime statistics is
+ * enabled. Several counters are updated, for the cost of one check.
+ *
+ * @param nlookups Number of keys looked up.
+ * @param nlinks Number of entries followed.
+ * @param nprobes Number of trie nodes visited.
+ */
+static void count_lookup(const unsigned nlookups, const unsigned nlinks,
+    const unsigned nprobes) {
+  if (libbirch::stats_enabled.loadRelaxed()) {
+    auto& s = libbirch::thread_stats();
+    ++s.nchains;
+    s.nlookups += nlookups;
+    s.nlinks += nlinks;
+    s.nprobes += nprobes;
+  }
+}
+
 libbirch::Label::Label() : Any(0) {
   //
 }
@@ -10,33 +29,34 @@ libbirch::Label::Label() : Any(0) {
 libbirch::Label::Label(const Label& o) :
     Label() {
   auto& o1 = const_cast<Label&>(o);
+  Memo::Released released;
   o1.lock.setWrite();
   o1.memo.rehash();
+  o1.memo.takeRetired(released);
   o1.lock.downgrade();
   memo.copy(o1.memo);
   o1.lock.unsetRead();
+  Memo::release(released);
+}
+
+void libbirch::Label::unsetWrite() {
+  Memo::Released released;
+  memo.takeRetired(released);
+  lock.unsetWrite();
+  Memo::release(released);
 }
 
 libbirch::Any* libbirch::Label::mapGet(Any* o) {
-  Any* prev = nullptr;
-  Any* next = o;
-  bool frozen = o->isFrozen();
-  while (frozen && next) {
-    prev = next;
-    next = memo.get(prev);
-    if (next) {
-      frozen = next->isFrozen();
-    }
-  }
-  if (!next) {
-	  next = prev;
-	}
-  if (frozen) {
+  unsigned nlinks = 0u;
+  auto next = mapFind(o, nlinks);
+  auto last = next;  // last object in the chain with an entry
+  if (next->isFrozen()) {
     if (next->isUnique()) {
       /* final-reference optimization: the pointer being updated is the final
        * remaining pointer to the object, rather than copying the object and
        * then destroying it, recycle the object to be the copy */
       next->recycle(this);
+      count_stat(&Stats::nrecycles);
     } else {
       /* copy the object */
       auto copied = next->copy(this);
@@ -47,28 +67,72 @@ libbirch::Any* libbirch::Label::mapGet(Any* o) {
       if (!next->isFrozenUnique()) {
         thaw();
         memo.put(next, copied);
+        last = copied;
+        ++nlinks;
       }
       next = copied;
+      count_stat(&Stats::ncopies);
     }
+  } else if (nlinks > 0u) {
+    count_stat(&Stats::nhits);
+  }
+  if (nlinks >= COMPRESS_LINKS) {
+    thaw();
+    memo.compress(o, last);
   }
   assert(!next->isFrozen());
   return next;
 }
 
-libbirch::Any* libbirch::Label::mapPull(Any* o) {
+libbirch::Any* libbirch::Label::mapPull(Any* o, unsigned& nlinks) {
+  Any* prev = nullptr;
+  Any* next = o;
+  unsigned nlookups = 0u, nprobes = 0u;
+  bool frozen = o->isFrozen();
+  while (frozen && next) {
+    prev = next;
+    next = memo.read(prev, nprobes);
+    ++nlookups;
+    if (next) {
+      ++nlinks;
+      frozen = next->isFrozen();
+    }
+  }
+  if (!next) {
+	  next = prev;
+	}
+  count_lookup(nlookups, nlinks, nprobes);
+  return next;
+}
+
+libbirch::Any* libbirch::Label::mapCompress(Any* o) {
+  unsigned nlinks = 0u;
+  auto next = mapFind(o, nlinks);
+  if (nlinks >= COMPRESS_LINKS) {
+    thaw();
+    memo.compress(o, next);
+  }
+  return next;
+}
+
+libbirch::Any* libbirch::Label::mapFind(Any* o, unsigned& nlinks) {
   Any* prev = nullptr;
   Any* next = o;
+  unsigned nlookups = 0u, nprobes = 0u;
   bool frozen = o->isFrozen();
   while (frozen && next) {
     prev = next;
-    next = memo.get(prev);
+    next = memo.get(prev, nprobes);
+    ++nlookups;
     if (next) {
+      ++nlinks;
       frozen = next->isFrozen();
     }
   }
   if (!next) {
 	  next = prev;
 	}
+  count_lookup(nlookups, nlinks, nprobes);
   return next;
 }
 
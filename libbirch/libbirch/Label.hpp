@@ -14,6 +14,12 @@ namespace libbirch {
  */
 class Label final : public Any {
 public:
+  /**
+   * Number of entries that a lookup must follow for the chain of them to be
+   * shortened. See Memo::compress().
+   */
+  static constexpr unsigned COMPRESS_LINKS = 2u;
+
   /**
    * Constructor.
    */
@@ -33,14 +39,30 @@ public:
   auto get(P& o)  {
     auto ptr = o.get();
     if (ptr && ptr->isFrozen()) {  // isFrozen a useful guard for performance
-      lock.setWrite();
-      ptr = o.get();  // reload now that within critical region
+      /* first look up the memo without locking, which suffices if the object
+       * has already been copied; the lock is required only to copy it */
+      Memo::enter();
       auto old = ptr;
-      ptr = static_cast<typename P::value_type*>(mapGet(old));
-      if (ptr != old) {
+      unsigned nlinks = 0u;
+      ptr = static_cast<typename P::value_type*>(mapPull(old, nlinks));
+      bool frozen = ptr->isFrozen();
+      bool compress = nlinks >= COMPRESS_LINKS;
+      if (!frozen && !compress && ptr != old) {
         o.replace(ptr);
       }
-      lock.unsetWrite();
+      Memo::exit();
+
+      if (frozen || compress) {
+        /* mapGet() also shortens the chain, which requires the lock */
+        lock.setWrite();
+        ptr = o.get();  // reload now that within critical region
+        old = ptr;
+        ptr = static_cast<typename P::value_type*>(mapGet(old));
+        if (ptr != old) {
+          o.replace(ptr);
+        }
+        unsetWrite();
+      }
     }
     return ptr;
   }
@@ -54,14 +76,28 @@ public:
   auto pull(P& o) {
     auto ptr = o.get();
     if (ptr && ptr->isFrozen()) {  // isFrozen a useful guard for performance
-      lock.setRead();
-      ptr = o.get();  // reload now that within critical region
+      Memo::enter();
       auto old = ptr;
-      ptr = static_cast<typename P::value_type*>(mapPull(old));
-      if (ptr != old) {
+      unsigned nlinks = 0u;
+      ptr = static_cast<typename P::value_type*>(mapPull(old, nlinks));
+      bool compress = nlinks >= COMPRESS_LINKS;
+      if (!compress && ptr != old) {
         o.replace(ptr);
       }
-      lock.unsetRead();
+      Memo::exit();
+
+      if (compress) {
+        /* shortening the chain requires the lock, which cannot be taken
+         * within a read section */
+        lock.setWrite();
+        ptr = o.get();  // reload now that within critical region
+        old = ptr;
+        ptr = static_cast<typename P::value_type*>(mapCompress(old));
+        if (ptr != old) {
+          o.replace(ptr);
+        }
+        unsetWrite();
+      }
     }
     return ptr;
   }
@@ -76,13 +112,15 @@ public:
     if (ptr && ptr->isFrozen()) {  // isFrozen a useful guard for performance
       lock.setWrite();
       ptr = static_cast<T*>(mapGet(ptr));
-      lock.unsetWrite();
+      unsetWrite();
     }
     return ptr;
   }
 
   /**
-   * Map a raw pointer for reading, with no locking.
+   * Map a raw pointer for reading, with no read section. This is for use
+   * only while the lock is held for writing, so that the memo cannot be
+   * rehashed.
    *
    * @param ptr Raw pointer.
    */
@@ -90,7 +128,8 @@ public:
   T* pullNoLock(T* ptr) {
     if (ptr) {
       assert(ptr->isFrozen());
-      ptr = static_cast<T*>(mapPull(ptr));
+      unsigned nlinks = 0u;
+      ptr = static_cast<T*>(mapPull(ptr, nlinks));
     }
     return ptr;
   }
@@ -105,23 +144,50 @@ public:
     if (ptr && ptr->isFrozen()) {  // isFrozen a useful guard for performance
       lock.setWrite();
       ptr = static_cast<T*>(mapCopy(ptr));
-      lock.unsetWrite();
+      unsetWrite();
     }
     return ptr;
   }
 
 private:
+  /**
+   * Release the lock for writing, then release the references that the memo
+   * has retired, once no concurrent reader may still be using them. See
+   * Memo for details.
+   */
+  void unsetWrite();
+
   /**
    * Map an object that may not yet have been cloned, cloning it if
-   * necessary.
+   * necessary, and shortening its chain of entries if long.
    */
   Any* mapGet(Any* o);
 
   /**
    * Map an object that may not yet have been cloned, without cloning it.
-   * This is used as an optimization for read-only access.
+   * This is used as an optimization for read-only access, and does not
+   * require the lock.
+   *
+   * @param o Object.
+   * @param[out] nlinks Number of entries followed.
    */
-  Any* mapPull(Any* o);
+  Any* mapPull(Any* o, unsigned& nlinks);
+
+  /**
+   * Map an object that may not yet have been cloned, without cloning it,
+   * but shortening its chain of entries if long. This requires the lock.
+   */
+  Any* mapCompress(Any* o);
+
+  /**
+   * Follow the chain of entries from an object to its end, which is either
+   * an object that is not frozen, or one without an entry. This requires
+   * the lock.
+   *
+   * @param o Object.
+   * @param[out] nlinks Number of entries followed.
+   */
+  Any* mapFind(Any* o, unsigned& nlinks);
 
   /**
    * Map an object that must be immediately cloned.
@@ -134,7 +200,9 @@ private:
   Memo memo;
 
   /**
-   * Lock.
+   * Lock. Lookups do not require the lock, only updates of the memo
+   * require it for writing, and traversals of the memo (finish and freeze)
+   * require it for reading, as does the copy of a label.
    */
   ReadersWriterLock lock;
 
@@ -183,6 +251,14 @@ public:
     memo.collect();
   }
 
+  virtual void discover_(const Discoverer& v) override {
+    //
+  }
+
+  virtual void copyEager_(const EagerCopier& v) override {
+    //
+  }
+
   using base_type = Any;
 };
 
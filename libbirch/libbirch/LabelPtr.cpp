@@ -13,15 +13,15 @@ libbirch::LabelPtr::LabelPtr(Label* ptr) :
 }
 
 libbirch::LabelPtr::LabelPtr(const LabelPtr& o) {
-  auto ptr = o.ptr.load();
+  auto ptr = o.ptr.loadAcquire();
   if (ptr && ptr != root()) {
     ptr->incShared();
   }
-  this->ptr.store(ptr);
+  this->ptr.storeRelaxed(ptr);
 }
 
 libbirch::LabelPtr::LabelPtr(LabelPtr&& o) {
-  ptr.store(o.ptr.exchange(nullptr));
+  ptr.storeRelaxed(o.ptr.exchange(nullptr));
 }
 
 libbirch::LabelPtr::~LabelPtr() {
@@ -29,7 +29,7 @@ libbirch::LabelPtr::~LabelPtr() {
 }
 
 void libbirch::LabelPtr::bitwiseFix() {
-  auto ptr = this->ptr.load();
+  auto ptr = this->ptr.loadRelaxed();
   if (ptr && ptr != root()) {
     ptr->incShared();
   }
@@ -54,11 +54,12 @@ libbirch::LabelPtr& libbirch::LabelPtr::operator=(LabelPtr&& o) {
 }
 
 bool libbirch::LabelPtr::query() const {
-  return ptr.load() != nullptr;
+  return ptr.loadAcquire() != nullptr;
 }
 
 libbirch::Label* libbirch::LabelPtr::get() const {
-  return ptr.load();
+  auto ptr = this->ptr.loadAcquire();
+  return ptr ? ptr : root();
 }
 
 void libbirch::LabelPtr::replace(Label* ptr) {
@@ -90,12 +91,21 @@ libbirch::Label* libbirch::LabelPtr::operator->() const {
   return get();
 }
 
+void libbirch::LabelPtr::possibleRoot() {
+  /* c.f. Shared::possibleRoot(); because we don't keep a shared reference to
+   * the root label, it is never the root of a cycle */
+  auto o = ptr.loadRelaxed();
+  if (o && o != root()) {
+    o->possibleRoot();
+  }
+}
+
 void libbirch::LabelPtr::mark() {
   /* c.f. Shared::mark(); because we don't keep a shared reference to the root
    * label, it is not necessary to recurse into it */
-  auto o = ptr.load();
+  auto o = ptr.loadRelaxed();
   if (o && o != root()) {
-    o->decSharedReachable();
+    o->breakShared();
     o->mark();
   }
 }
@@ -103,7 +113,7 @@ void libbirch::LabelPtr::mark() {
 void libbirch::LabelPtr::scan() {
   /* c.f. Shared::scan(); because we don't keep a shared reference to the root
    * label, it is not necessary to recurse into it */
-  auto o = ptr.load();
+  auto o = ptr.loadRelaxed();
   if (o && o != root()) {
     o->scan();
   }
@@ -112,9 +122,9 @@ void libbirch::LabelPtr::scan() {
 void libbirch::LabelPtr::reach() {
   /* c.f. Shared::reach(); because we don't keep a shared reference to the
    * root label, it is not necessary to recurse into it */
-  auto o = ptr.load();
+  auto o = ptr.loadRelaxed();
   if (o && o != root()) {
-    o->incShared();
+    o->restoreShared();
     o->reach();
   }
 }
@@ -13,7 +13,8 @@ class Label;
 /**
  * LabelPtr pointer to a Label object. Provides some optimizations over
  * LabelPtr<Label>, e.g. reference counts to the root label need not be
- * updated.
+ * updated. A null pointer is taken to be the root label, so that objects
+ * need not load the root label on construction.
  *
  * @ingroup libbirch
  */
@@ -65,7 +66,7 @@ public:
   bool query() const;
 
   /**
-   * Get the raw pointer.
+   * Get the raw pointer. This is the root label if the pointer is null.
    */
   Label* get() const;
 
@@ -89,6 +90,11 @@ public:
    */
   Label* operator->() const;
 
+  /**
+   * Register the label as a possible root for cycle collection.
+   */
+  void possibleRoot();
+
   /**
    * Mark.
    */
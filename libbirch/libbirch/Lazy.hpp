@@ -18,6 +18,11 @@ namespace libbirch {
  * @ingroup libbirch
  *
  * @tparam P Pointer type, e.g. Shared or Init.
+ *
+ * The root label is represented by a null label. Most objects are never
+ * involved in a clone, and remain in the root label, so this saves loading
+ * the root label on construction, and on dereference, where the label is
+ * only consulted if the object is frozen.
  */
 template<class P>
 class Lazy {
@@ -36,10 +41,13 @@ public:
 
   /**
    * Constructor.
+   *
+   * @param ptr Raw pointer.
+   * @param label Label, or null for the root label.
    */
   Lazy(value_type* ptr, Label* label = nullptr) :
       object(ptr),
-      label(label ? label : ptr->Any::getLabel()) {
+      label(label) {
     //
   }
 
@@ -51,13 +59,13 @@ public:
    * it by calling its default constructor.
    */
   Lazy() :
-      object(new value_type()),
-      label(root()) {
+      object(new value_type()) {
     static_assert(std::is_default_constructible<value_type>::value,
         "invalid call to class constructor");
     // ^ ideally this condition would be checked with SFINAE, but the
     //   definition of value_type may not be available at the point that a
     //   pointer to it is declared, causing a compile error
+    object.get()->Any::profile();
   }
 
   /**
@@ -77,9 +85,8 @@ public:
   template<class Arg, std::enable_if_t<!std::is_base_of<value_type,
       typename raw<Arg>::type>::value,int> = 0>
   explicit Lazy(const Arg& arg) :
-      object(new value_type(arg)),
-      label(root()) {
-    //
+      object(new value_type(arg)) {
+    object.get()->Any::profile();
   }
 
   /**
@@ -99,9 +106,8 @@ public:
    */
   template<class Arg1, class Arg2, class... Args>
   explicit Lazy(const Arg1& arg1, const Arg2& arg2, const Args&... args) :
-      object(new value_type(arg1, arg2, args...)),
-      label(root()) {
-    //
+      object(new value_type(arg1, arg2, args...)) {
+    object.get()->Any::profile();
   }
 
   /**
@@ -155,6 +161,21 @@ public:
     new (&label) label_type(newLabel);  // overwrite with new label
   }
 
+  /**
+   * Correctly initialize after a bitwise copy, for an eager copy. The
+   * referent has also been copied; the copy is in the root label.
+   *
+   * @tparam M Map type, e.g. EagerMap.
+   *
+   * @param map Map from the objects of the eager copy to their copies.
+   */
+  template<class M>
+  void bitwiseFixEager(const M& map) {
+    auto ptr = static_cast<value_type*>(map.get(object.get()));
+    new (&object) pointer_type(ptr);
+    new (&label) label_type();  // root label
+  }
+
   /**
    * Value assignment.
    */
@@ -236,8 +257,11 @@ public:
     if (label) {
       return label->get(object);
     } else {
-      assert(!object.query());
-      return nullptr;
+      auto ptr = object.get();
+      if (ptr && ptr->isFrozen()) {
+        ptr = root()->get(object);
+      }
+      return ptr;
     }
   }
 
@@ -256,8 +280,11 @@ public:
     if (label) {
       return label->pull(object);
     } else {
-      assert(!object.query());
-      return nullptr;
+      auto ptr = object.get();
+      if (ptr && ptr->isFrozen()) {
+        ptr = root()->pull(object);
+      }
+      return ptr;
     }
   }
 
@@ -288,7 +315,8 @@ public:
    * Get the label associated with the pointer.
    */
   Label* getLabel() const {
-    return label.get();
+    auto label = this->label.get();
+    return label ? label : root();
   }
 
   /**
@@ -319,6 +347,13 @@ public:
     object.get()->Any::freeze();
   }
 
+  /**
+   * Register the referent as a possible root for cycle collection.
+   */
+  void possibleRoot() {
+    object.possibleRoot();
+  }
+
   /**
    * Mark.
    */
@@ -358,7 +393,7 @@ private:
   pointer_type object;
 
   /**
-   * Label.
+   * Label, or null for the root label.
    */
   label_type label;
 };
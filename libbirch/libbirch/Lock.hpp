@@ -43,7 +43,7 @@ public:
    */
   void set() {
     /* spin, setting the lock true until its old value comes back false */
-    while (lock.exchange(true));
+    while (lock.exchangeAcquire(true));
   }
 
 
@@ -51,7 +51,7 @@ public:
    * Release exclusive use.
    */
   void unset() {
-    lock.store(false);
+    lock.storeRelease(false);
   }
 
 private:
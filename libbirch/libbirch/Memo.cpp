@@ -3,262 +3,277 @@
  */
 #include "libbirch/Memo.hpp"
 
-#include "libbirch/Any.hpp"
+#include "libbirch/MemoNode.hpp"
+
+/**
+ * Read section of a thread, on its own cache line.
+ */
+struct alignas(64) ReadSection {
+  /**
+   * Epoch at which the thread entered its current read section, or zero if
+   * it is not in one.
+   */
+  libbirch::Atomic<unsigned> epoch;
+};
+
+/**
+ * Make the read sections.
+ */
+static ReadSection* make_read_sections() {
+  /* value initialization zeros the epochs */
+  return libbirch::make_thread_array<ReadSection>(libbirch::get_max_threads());
+}
+
+/**
+ * Get the read section of the `i`th thread.
+ */
+static ReadSection& read_section(const int i) {
+  static ReadSection* sections = make_read_sections();
+  return sections[i];
+}
+
+/**
+ * Get the current epoch, which starts at one, as zero is reserved to indicate
+ * that a thread is not in a read section.
+ */
+static libbirch::Atomic<unsigned>& epoch() {
+  static libbirch::Atomic<unsigned> epoch(1u);
+  return epoch;
+}
 
 libbirch::Memo::Memo() :
-    keys(nullptr),
-    values(nullptr),
-    nentries(0u),
-    tentries(0u),
+    root(nullptr),
     noccupied(0u),
     nnew(0u) {
   //
 }
 
 libbirch::Memo::~Memo() {
-  if (nentries > 0u) {
-    for (unsigned i = 0u; i < nentries; ++i) {
-      auto key = keys[i];
-      if (key) {
-        key->decMemo();
-        auto value = values[i];
-        if (value) {  // may be null if collect() already destroyed
-          value->decShared();
-        }
-      }
-    }
-    deallocate(keys, nentries * sizeof(key_type), tentries);
-    deallocate(values, nentries * sizeof(value_type), tentries);
+  auto o = root.loadRelaxed();
+  if (o) {  // may be null if collect() already destroyed
+    o->decShared();
   }
+  releaseNow(retired);
 }
 
 libbirch::Memo::value_type libbirch::Memo::get(const key_type key,
-    const value_type failed) {
+    unsigned& nprobes) {
   assert(key);
+  return MemoNode::get(root.loadRelaxed(), key, nprobes);
+}
 
-  auto value = failed;
-  if (!empty()) {
-    auto i = hash(key, nentries);
-    auto k = keys[i];
-    while (k && k != key) {
-      i = (i + 1u) & (nentries - 1u);
-      k = keys[i];
-    }
-    if (k == key) {
-      value = values[i];
-    }
-  }
-  return value;
+libbirch::Memo::value_type libbirch::Memo::read(const key_type key,
+    unsigned& nprobes) const {
+  assert(key);
+  /* sequentially consistent, so that this is not reordered with the store
+   * in enter() */
+  return MemoNode::get(root.load(), key, nprobes);
 }
 
 void libbirch::Memo::put(const key_type key, const value_type value) {
   assert(key);
   assert(value);
+  #ifndef NDEBUG
+  unsigned nprobes = 0u;
+  assert(!get(key, nprobes));
+  #endif
 
   key->incMemo();
   value->incShared();
 
   reserve();
-  auto i = hash(key, nentries);
-  auto k = keys[i];
-  while (k) {
-    assert(k != key);
-    i = (i + 1u) & (nentries - 1u);
-    k = keys[i];
+  auto node = root.loadRelaxed();
+  MemoNode::insert(node, key, value, retired);
+  root.store(node);
+  count_stat(&Stats::nputs);
+}
+
+void libbirch::Memo::compress(const key_type key, const value_type value) {
+  assert(key);
+  assert(value);
+  value->incShared();
+  auto node = root.loadRelaxed();
+  auto prev = MemoNode::replace(node, key, value, retired);
+  root.store(node);
+  retired.values.push_back(prev);
+  count_stat(&Stats::ncompressions);
+}
+
+void libbirch::Memo::takeRetired(Released& released) {
+  /* each write retires a few nodes, so wait for a small batch of them
+   * before releasing them; a larger batch would amortize the wait better,
+   * but the retired nodes of a label that is no longer written would then
+   * hold more memory */
+  if (retired.size() > 32u) {
+    std::swap(released, retired);
+  }
+}
+
+void libbirch::Memo::release(Released& released) {
+  if (released.size() > 0u) {
+    synchronize();
+    releaseNow(released);
+  }
+}
+
+void libbirch::Memo::releaseNow(Released& released) {
+  for (auto o : released.keys) {
+    o->decMemo();
+  }
+  for (auto o : released.values) {
+    if (o) {  // may be null if collect() already destroyed
+      o->decShared();
+    }
+  }
+  for (auto o : released.nodes) {
+    if (o) {  // may be null if collect() already destroyed
+      o->decShared();
+    }
+  }
+  for (auto o : released.moved) {
+    MemoNode::discard(o);
+  }
+  released.keys.clear();
+  released.values.clear();
+  released.nodes.clear();
+  released.moved.clear();
+}
+
+void libbirch::Memo::enter() {
+  /* sequentially consistent, so that either synchronize() sees this, or
+   * the subsequent read() sees the write that preceded it; acquire, so that
+   * the same holds if the epoch is already that of synchronize() */
+  read_section(get_thread_num()).epoch.store(epoch().loadAcquire());
+}
+
+void libbirch::Memo::exit() {
+  read_section(get_thread_num()).epoch.storeRelease(0u);
+}
+
+void libbirch::Memo::synchronize() {
+  auto e = ++epoch();
+  auto tid = get_thread_num();
+  for (int i = 0; i < get_max_threads(); ++i) {
+    if (i != tid) {
+      /* a thread in a read section that it entered at epoch e or later
+       * began its read after the write, so need not be waited for */
+      unsigned f;
+      do {
+        f = read_section(i).epoch.load();
+      } while (f != 0u && f < e);
+    }
   }
-  keys[i] = key;
-  values[i] = value;
 }
 
 void libbirch::Memo::copy(const Memo& o) {
   assert(empty());
 
   /* strategy here is to assume the parent has been rehashed to reduce its
-   * size and remove unreachable entries, so now just copy entry-by-entry */
-  if (o.nentries > 0u) {
-    /* allocate */
-    keys = (key_type*)allocate(o.nentries * sizeof(key_type));
-    values = (value_type*)allocate(o.nentries * sizeof(value_type));
-    nentries = o.nentries;
-    tentries = get_thread_num();
-    noccupied = o.noccupied;
-    nnew = o.nnew;
-
-    /* copy entry-by-entry, incrementing reference counts for non-null
-     * entries */
-    for (auto i = 0u; i < nentries; ++i) {
-      auto key = o.keys[i];
-      auto value = o.values[i];
-      if (key) {
-        key->incMemo();
-        value->incShared();
-      }
-      keys[i] = key;
-      values[i] = value;
-    }
+   * size and remove unreachable entries, so now just share its trie */
+  auto node = o.root.loadRelaxed();
+  if (node) {
+    node->incShared();
   }
+  root.store(node);
+  noccupied = o.noccupied;
+  nnew = o.nnew;
 }
 
 void libbirch::Memo::reserve() {
   ++nnew;
   ++noccupied;
-  if (noccupied > crowd()) {
+  if (nnew > crowd()) {
     rehash();
   }
 }
 
 void libbirch::Memo::rehash() {
-  if (nnew > 0u) {  // no need to rehash if no new entries since last time
+  if (nnew > 0u) {
+    /* no need to rehash if no new entries since last time */
     nnew = 0u;
-    unsigned nremoved = 0u;
+    count_stat(&Stats::nrehashes);
 
-    /* first pass, apply the table to itself; this has the effect of
+    /* first pass, apply the trie to itself; this has the effect of
      * replacing a -> b and b -> c with a -> c and b -> c, which may allow
      * b to be collected sooner */
-    for (auto i = 0u; i < nentries; ++i) {
-      auto value = values[i];
-      if (value) {
-        auto prev = value;
-        auto next = value;
-        do {
-          prev = next;
-          next = get(prev);
-        } while (next);
-        if (prev != value) {
-          prev->incShared();
-          value->decShared();
-          values[i] = prev;
-        }
-      }
-    }
-
-    /* second pass, delete any entries where the key is no longer reachable;
-     * from this point, the old buffers are no long valid as a hash table */
-    for (auto i = 0u; i < nentries; ++i) {
-      auto key = keys[i];
-      if (key && key->isDestroyed()) {
-        auto value = values[i];
-        key->decMemo();
-        value->decShared();
-        keys[i] = nullptr;
-        values[i] = nullptr;
-        ++nremoved;
-      }
-    }
-    noccupied -= nremoved;
-
-    if (noccupied == 0u) {
-      /* deallocate previous table */
-      if (nentries > 0) {
-        deallocate(keys, nentries * sizeof(key_type), tentries);
-        deallocate(values, nentries * sizeof(value_type), tentries);
-      }
-
-      /* new table empty */
-      nentries = 0u;
-      tentries = 0u;
-      keys = nullptr;
-      values = nullptr;
-    } else {
-      /* save previous table */
-      auto nentries1 = nentries;
-      auto tentries1 = tentries;
-      auto keys1 = keys;
-      auto values1 = values;
-
-      /* choose an appropriate size for the new table */
-      unsigned minSize = 8u;
-      nentries = std::max(2u*nentries1, minSize);
-      while (minSize < nentries && noccupied <= crowd()/2) {
-        nentries /= 2u;
-      }
-
-      if (nentries != nentries1 || nremoved > 0u) {
-        /* allocate the new table */
-        keys = (key_type*)allocate(nentries * sizeof(key_type));
-        values = (value_type*)allocate(nentries * sizeof(value_type));
-        std::memset(keys, 0, nentries * sizeof(key_type));
-        std::memset(values, 0, nentries * sizeof(value_type));
-        tentries = get_thread_num();
+    auto old = root.loadRelaxed();
+    auto node = old;
+    MemoNode::compress(node, old, retired);
 
-        /* copy entries from previous table */
-        for (auto i = 0u; i < nentries1; ++i) {
-          auto key = keys1[i];
-          if (key) {
-            auto j = hash(key, nentries);
-            while (keys[j]) {
-              j = (j + 1u) & (nentries - 1u);
-            }
-            keys[j] = key;
-            values[j] = values1[i];
-          }
-        }
-
-        /* deallocate previous table */
-        if (nentries1 > 0u) {
-          deallocate(keys1, nentries1 * sizeof(key_type), tentries1);
-          deallocate(values1, nentries1 * sizeof(value_type), tentries1);
-        }
-      }
-    }
+    /* second pass, delete any entries where the key is no longer
+     * reachable */
+    noccupied -= MemoNode::prune(node, retired);
+    root.store(node);
   }
 }
 
 void libbirch::Memo::finish(Label* label) {
-  for (auto i = 0u; i < nentries; ++i) {
-    auto key = keys[i];
-    if (key && !key->isDestroyed()) {
-      auto value = values[i];
-      value->finish(label);
-    }
-  }
+  MemoNode::finish(root.loadRelaxed(), label);
 }
 
 void libbirch::Memo::freeze() {
-  for (auto i = 0u; i < nentries; ++i) {
-    auto key = keys[i];
-    if (key && !key->isDestroyed()) {
-      auto value = values[i];
-      value->freeze();
-    }
-  }
+  MemoNode::freeze(root.loadRelaxed());
 }
 
 void libbirch::Memo::mark() {
-  for (auto i = 0u; i < nentries; ++i) {
-    auto value = values[i];
-    if (value) {
-      value->decSharedReachable();  // break the reference
-      value->mark();
-    }
+  auto o = root.loadRelaxed();
+  if (o) {
+    o->breakShared();  // break the reference
+    o->mark();
+  }
+  for (auto o : retired.values) {
+    o->breakShared();
+    o->mark();
+  }
+  for (auto o : retired.nodes) {
+    o->breakShared();
+    o->mark();
   }
 }
 
 void libbirch::Memo::scan() {
-  for (auto i = 0u; i < nentries; ++i) {
-    auto value = values[i];
-    if (value) {
-      value->scan();
-    }
+  auto o = root.loadRelaxed();
+  if (o) {
+    o->scan();
+  }
+  for (auto o : retired.values) {
+    o->scan();
+  }
+  for (auto o : retired.nodes) {
+    o->scan();
   }
 }
 
 void libbirch::Memo::reach() {
-  for (auto i = 0u; i < nentries; ++i) {
-    auto value = values[i];
-    if (value) {
-      value->incShared();  // restore the broken reference
-      value->reach();
-    }
+  auto o = root.loadRelaxed();
+  if (o) {
+    o->restoreShared();  // restore the broken reference
+    o->reach();
+  }
+  for (auto o : retired.values) {
+    o->restoreShared();
+    o->reach();
+  }
+  for (auto o : retired.nodes) {
+    o->restoreShared();
+    o->reach();
   }
 }
 
 void libbirch::Memo::collect() {
-  for (auto i = 0u; i < nentries; ++i) {
-    auto value = values[i];
-    if (value) {
-      values[i] = nullptr;
-      value->collect();
-    }
+  auto o = root.loadRelaxed();
+  root.storeRelaxed(nullptr);
+  if (o) {
+    o->collect();
+  }
+  for (auto& o : retired.values) {
+    auto o1 = o;
+    o = nullptr;
+    o1->collect();
+  }
+  for (auto& o : retired.nodes) {
+    auto o1 = o;
+    o = nullptr;
+    o1->collect();
   }
 }
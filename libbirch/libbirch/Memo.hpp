@@ -4,15 +4,47 @@
 #pragma once
 
 #include "libbirch/ReadersWriterLock.hpp"
+#include "libbirch/Allocator.hpp"
 
 namespace libbirch {
 class Any;
 class Label;
+class MemoNode;
 
 /**
- * Memo of object mappings, implemented as a hash table.
+ * Memo of object mappings, implemented as a persistent hash array mapped
+ * trie (HAMT).
  *
  * @ingroup libbirch
+ *
+ * Copying a memo shares the trie with the original, so that a copy is a
+ * constant-time operation, and each memo then pays only for the entries
+ * that it adds itself. See MemoNode for details.
+ *
+ * Writes (put(), compress(), rehash()) require exclusive access, which the
+ * owning Label provides with its lock. Reads (read()) may proceed
+ * concurrently with writes, without locking. For this, nodes of the trie
+ * are never modified once reachable from the root: a write builds new nodes
+ * for the path from the root to the entries that it changes (path copying),
+ * and publishes the new root with a single atomic store, so that a read sees
+ * either the old trie or the new trie, in full.
+ *
+ * The nodes and values that a write removes from the trie are not released
+ * immediately, as concurrent reads may still be using them. They are
+ * retired instead, and only released once all threads have exited any read
+ * sections that they entered before the write; a read must therefore be made
+ * between enter() and exit(), along with any use of its result, e.g. to
+ * take a reference to it. Waiting for threads to exit their read sections
+ * must not be done while holding the lock, as those threads may themselves
+ * be waiting for it, so the owning Label takes the retired references with
+ * takeRetired() before releasing the lock, and passes them to release()
+ * after.
+ *
+ * Lookups through a label follow chains of entries, e.g. a -> b -> c, where
+ * b was itself copied and then frozen by an earlier clone. The owning Label
+ * shortens these as it finds them, with compress(), and counts their
+ * lengths, along with the number of trie nodes visited, in the runtime
+ * statistics (see Stats), when enabled.
  */
 class Memo {
 public:
@@ -45,11 +77,32 @@ public:
    * Get a value.
    *
    * @param key Key.
+   * @param[in,out] nprobes Incremented by the number of trie nodes visited.
    *
-   * @return If @p key exists, then its associated value, otherwise
-   * @p failed.
+   * @return If @p key exists, then its associated value, otherwise null.
    */
-  value_type get(const key_type key, const value_type failed = nullptr);
+  value_type get(const key_type key, unsigned& nprobes);
+
+  /**
+   * Get a value, without locking. This must be called within a read
+   * section (see enter()).
+   *
+   * @param key Key.
+   * @param[in,out] nprobes Incremented by the number of trie nodes visited.
+   *
+   * @return If @p key exists, then its associated value, otherwise null.
+   */
+  value_type read(const key_type key, unsigned& nprobes) const;
+
+  /**
+   * Enter a read section on the current thread. See Memo for details.
+   */
+  static void enter();
+
+  /**
+   * Exit a read section on the current thread.
+   */
+  static void exit();
 
   /**
    * Put an entry.
@@ -60,13 +113,78 @@ public:
   void put(const key_type key, const value_type value);
 
   /**
-   * Copy entries from another map into this one, removing any that are
-   * obsolete.
+   * Shorten a chain of entries, replacing the value of an entry with a value
+   * further along its chain, e.g. a -> b with a -> c where b -> c. This is
+   * what rehash() does for all entries, but for one entry, as it is found.
+   *
+   * @param key Key, which must exist.
+   * @param value New value.
+   *
+   * The previous value is retired, as it may still be in use by a
+   * concurrent reader.
+   */
+  void compress(const key_type key, const value_type value);
+
+  /**
+   * References removed from the trie, which concurrent readers may still be
+   * using.
+   */
+  struct Released {
+    /**
+     * Keys, each with a memo reference.
+     */
+    std::vector<Any*,Allocator<Any*>> keys;
+
+    /**
+     * Values, each with a shared reference.
+     */
+    std::vector<Any*,Allocator<Any*>> values;
+
+    /**
+     * Nodes, each with a shared reference.
+     */
+    std::vector<MemoNode*,Allocator<MemoNode*>> nodes;
+
+    /**
+     * Nodes that have been replaced by copies, to which the contents of
+     * their slots, along with the references to them, have been moved.
+     */
+    std::vector<MemoNode*,Allocator<MemoNode*>> moved;
+
+    /**
+     * Number of references.
+     */
+    size_t size() const {
+      return keys.size() + values.size() + nodes.size() + moved.size();
+    }
+  };
+
+  /**
+   * Take the references that have been retired, if there are enough of them
+   * to warrant the wait in release().
+   *
+   * @param[out] released Empty object to receive the references.
+   */
+  void takeRetired(Released& released);
+
+  /**
+   * Release references, once no concurrent reader may still be using them.
+   * This must not be called within a read section, or while holding the
+   * lock of the owning Label.
+   *
+   * @param released References from takeRetired().
+   */
+  static void release(Released& released);
+
+  /**
+   * Copy entries from another map into this one. The entries are shared
+   * with the other map, not copied.
    */
   void copy(const Memo& o);
 
   /**
-   * Rehash the table. This will also remove unreachable entries.
+   * Rehash the table. This will also remove unreachable entries. Entries
+   * shared with other maps are left unchanged.
    */
   void rehash();
 
@@ -102,14 +220,8 @@ public:
 
 private:
   /**
-   * Compute the hash code for a given key for a table with the given number
-   * of entries.
-   */
-  static unsigned hash(const key_type key, const unsigned nentries);
-
-  /**
-   * Compute the lower bound on the number of occupied entries before the
-   * table is considered too crowded.
+   * Compute the lower bound on the number of new entries since the last
+   * rehash before another rehash is due.
    */
   unsigned crowd() const;
 
@@ -118,29 +230,32 @@ private:
    * too crowded.
    */
   void reserve();
-  
+
   /**
-   * The keys.
+   * Wait until all threads other than the current thread have exited any
+   * read sections that they entered before now.
    */
-  key_type* keys;
+  static void synchronize();
 
   /**
-   * The values.
+   * Release references immediately.
    */
-  value_type* values;
+  static void releaseNow(Released& released);
 
   /**
-   * Number of entries in the table.
+   * Root node of the trie. Only written by a writer, read by both readers
+   * and writers.
    */
-  unsigned nentries;
+  Atomic<MemoNode*> root;
 
   /**
-   * Id of the thread that allocated keys and values.
+   * References removed from the trie, to be released once no concurrent
+   * reader may still be using them.
    */
-  int tentries;
+  Released retired;
 
   /**
-   * Number of occupied entries in the table.
+   * Number of occupied entries in the trie.
    */
   unsigned noccupied;
 
@@ -152,17 +267,11 @@ private:
 }
 
 inline bool libbirch::Memo::empty() const {
-  return nentries == 0u;
-}
-
-inline unsigned libbirch::Memo::hash(const key_type key, const unsigned nentries) {
-  assert(nentries > 0u);
-  return static_cast<unsigned>(reinterpret_cast<size_t>(key) >> 6ull)
-      & (nentries - 1u);
+  return !root.loadRelaxed();
 }
 
 inline unsigned libbirch::Memo::crowd() const {
-  /* the table is considered crowded if more than three-quarters of its
-   * entries are occupied */
-  return (nentries >> 1u) + (nentries >> 2u);
+  /* rehash whenever the number of entries has roughly doubled since the last
+   * rehash, as a hash table would when resized */
+  return std::max(noccupied - nnew, 8u);
 }
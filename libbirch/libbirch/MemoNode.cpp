@@ -0,0 +1,360 @@
+/**
+ * @file
+ */
+#include "libbirch/MemoNode.hpp"
+
+libbirch::MemoNode::MemoNode(const unsigned capacity) :
+    bitmap(0u),
+    nslots(0u),
+    capacity(capacity) {
+  unbias();
+}
+
+libbirch::MemoNode::~MemoNode() {
+  auto s = slots();
+  for (auto i = 0u; i < nslots; ++i) {
+    if (s[i].key) {
+      s[i].key->decMemo();
+      if (s[i].value) {  // may be null if collect() already destroyed
+        s[i].value->decShared();
+      }
+    } else if (s[i].child) {  // may be null if collect() already destroyed
+      s[i].child->decShared();
+    }
+  }
+}
+
+libbirch::MemoNode* libbirch::MemoNode::make(const unsigned capacity) {
+  assert(0u < capacity && capacity <= 32u);
+  return ::new (allocate(size(capacity))) MemoNode(capacity);
+}
+
+libbirch::MemoNode* libbirch::MemoNode::make(const Slot* s,
+    const uint32_t bitmap, const unsigned nslots, const unsigned capacity) {
+  assert(capacity >= nslots);
+  auto node = make(capacity);
+  node->bitmap = bitmap;
+  node->nslots = nslots;
+  std::memcpy(node->slots(), s, nslots*sizeof(Slot));
+  return node;
+}
+
+libbirch::MemoNode* libbirch::MemoNode::make(const MemoNode* o,
+    const unsigned capacity) {
+  auto node = make(o->slots(), o->bitmap, o->nslots, capacity);
+  auto s = node->slots();
+  for (auto i = 0u; i < node->nslots; ++i) {
+    if (s[i].key) {
+      s[i].key->incMemo();
+      s[i].value->incShared();
+    } else {
+      s[i].child->incShared();
+    }
+  }
+  return node;
+}
+
+libbirch::MemoNode* libbirch::MemoNode::make(const key_type key1,
+    const value_type value1, const key_type key2, const value_type value2,
+    const int level) {
+  auto b1 = bit(key1, level);
+  auto b2 = bit(key2, level);
+  MemoNode* node = nullptr;
+  if (b1 == b2) {
+    node = make(1u);
+    node->slots()[0].key = nullptr;
+    node->slots()[0].child = make(key1, value1, key2, value2, level + 1);
+    node->nslots = 1u;
+  } else {
+    node = make(2u);
+    auto s = node->slots();
+    auto i = (b1 < b2) ? 0u : 1u;
+    s[i].key = key1;
+    s[i].value = value1;
+    s[1u - i].key = key2;
+    s[1u - i].value = value2;
+    node->nslots = 2u;
+  }
+  node->bitmap = (1u << b1) | (1u << b2);
+  node->incShared();
+  return node;
+}
+
+libbirch::MemoNode* libbirch::MemoNode::renew(MemoNode* o,
+    const unsigned capacity, Released& released) {
+  MemoNode* node = nullptr;
+  if (o->isShared()) {
+    /* shared with another trie, so take new references, and retire the
+     * reference to the old node */
+    node = make(o, capacity);
+    released.nodes.push_back(o);
+  } else {
+    /* otherwise take over the references of the old node */
+    node = make(o->slots(), o->bitmap, o->nslots, capacity);
+    released.moved.push_back(o);
+  }
+  node->incShared();
+  return node;
+}
+
+void libbirch::MemoNode::discard(MemoNode* o) {
+  assert(!o->isShared());
+  o->nslots = 0u;
+  o->bitmap = 0u;
+  o->decSharedAcyclic();
+}
+
+void libbirch::MemoNode::insert(MemoNode*& node, const key_type key,
+    const value_type value, Released& released) {
+  insert(node, key, value, 0, released);
+}
+
+void libbirch::MemoNode::insert(MemoNode*& node, const key_type key,
+    const value_type value, const int level, Released& released) {
+  assert(key);
+  assert(value);
+  auto b = bit(key, level);
+  if (!node) {
+    node = make(1u);
+    node->incShared();
+  } else {
+    bool occupied = node->bitmap & (1u << b);
+    node = renew(node, node->nslots + (occupied ? 0u : 1u), released);
+  }
+
+  /* the node is new, so may be modified in place */
+  auto s = node->slots();
+  auto i = node->position(b);
+  if (node->bitmap & (1u << b)) {
+    if (s[i].key) {
+      /* slot holds another entry, move both into a new child */
+      assert(s[i].key != key);
+      auto child = make(s[i].key, s[i].value, key, value, level + 1);
+      s[i].key = nullptr;
+      s[i].child = child;
+    } else {
+      insert(s[i].child, key, value, level + 1, released);
+    }
+  } else {
+    std::memmove(s + i + 1, s + i, (node->nslots - i)*sizeof(Slot));
+    s[i].key = key;
+    s[i].value = value;
+    node->bitmap |= (1u << b);
+    ++node->nslots;
+  }
+}
+
+libbirch::MemoNode::value_type libbirch::MemoNode::replace(MemoNode*& node,
+    const key_type key, const value_type value, Released& released) {
+  return replace(node, key, value, 0, released);
+}
+
+libbirch::MemoNode::value_type libbirch::MemoNode::replace(MemoNode*& node,
+    const key_type key, const value_type value, const int level,
+    Released& released) {
+  assert(node);
+  assert(value);
+  auto b = bit(key, level);
+  assert(node->bitmap & (1u << b));
+  node = renew(node, node->nslots, released);
+
+  /* the node is new, so may be modified in place */
+  auto& slot = node->slots()[node->position(b)];
+  if (slot.key) {
+    assert(slot.key == key);
+    auto prev = slot.value;
+    slot.value = value;
+    return prev;
+  } else {
+    return replace(slot.child, key, value, level + 1, released);
+  }
+}
+
+void libbirch::MemoNode::compress(MemoNode*& node, const MemoNode* root,
+    Released& released) {
+  if (node && !node->isShared()) {
+    /* work on a copy of the slots, as the node may be visited by
+     * concurrent readers, and replace it only if modified */
+    Slot s[32];
+    auto n = node->nslots;
+    std::memcpy(s, node->slots(), n*sizeof(Slot));
+    bool modified = false;
+    for (auto i = 0u; i < n; ++i) {
+      if (s[i].key) {
+        auto value = s[i].value;
+        auto prev = value;
+        auto next = value;
+        unsigned nprobes = 0u;
+        do {
+          prev = next;
+          next = get(root, prev, nprobes);
+        } while (next);
+        if (prev != value) {
+          prev->incShared();
+          released.values.push_back(value);
+          s[i].value = prev;
+          modified = true;
+        }
+      } else {
+        auto child = s[i].child;
+        compress(s[i].child, root, released);
+        modified = modified || s[i].child != child;
+      }
+    }
+    if (modified) {
+      released.moved.push_back(node);
+      node = make(s, node->bitmap, n, n);
+      node->incShared();
+    }
+  }
+}
+
+unsigned libbirch::MemoNode::prune(MemoNode*& node, Released& released) {
+  unsigned nremoved = 0u;
+  if (node && !node->isShared()) {
+    /* work on a copy of the slots, as for compress() */
+    Slot s[32];
+    auto bitmap = node->bitmap;
+    auto i = 0u;  // slot to read
+    auto j = 0u;  // slot to write
+    bool modified = false;
+    for (auto b = 0u; b < 32u; ++b) {
+      if (bitmap & (1u << b)) {
+        auto slot = node->slots()[i++];
+        bool keep = true;
+        if (slot.key) {
+          if (slot.key->isDestroyed()) {
+            released.keys.push_back(slot.key);
+            released.values.push_back(slot.value);
+            keep = false;
+            ++nremoved;
+          }
+        } else {
+          auto child = slot.child;
+          nremoved += prune(slot.child, released);
+          modified = modified || slot.child != child;
+          child = slot.child;
+          if (!child) {
+            keep = false;
+          } else if (child->nslots == 1u && child->slots()[0].key &&
+              !child->isShared()) {
+            /* child holds a single entry, move it up into this node */
+            slot = child->slots()[0];
+            released.moved.push_back(child);
+            modified = true;
+          }
+        }
+        if (keep) {
+          s[j++] = slot;
+        } else {
+          bitmap &= ~(1u << b);
+          modified = true;
+        }
+      }
+    }
+    if (modified) {
+      released.moved.push_back(node);
+      if (j > 0u) {
+        node = make(s, bitmap, j, j);
+        node->incShared();
+      } else {
+        node = nullptr;
+      }
+    }
+  }
+  return nremoved;
+}
+
+void libbirch::MemoNode::finish(MemoNode* node, Label* label) {
+  if (node) {
+    node->Any::finish(label);
+  }
+}
+
+void libbirch::MemoNode::freeze(MemoNode* node) {
+  if (node) {
+    if (!node->isFinished()) {
+      /* the node was created after its label was finished, by a write
+       * through a cross pointer during the finish of another clone; such
+       * writes finish the values that they insert, and the finish and
+       * freeze of clones never overlap, so only the flag is missing */
+      node->refinish();
+    }
+    node->Any::freeze();
+  }
+}
+
+void libbirch::MemoNode::finish_(Label* label) {
+  auto s = slots();
+  for (auto i = 0u; i < nslots; ++i) {
+    if (s[i].key) {
+      if (!s[i].key->isDestroyed()) {
+        s[i].value->finish(label);
+      }
+    } else {
+      finish(s[i].child, label);
+    }
+  }
+}
+
+void libbirch::MemoNode::freeze_() {
+  auto s = slots();
+  for (auto i = 0u; i < nslots; ++i) {
+    if (s[i].key) {
+      if (!s[i].key->isDestroyed()) {
+        s[i].value->freeze();
+      }
+    } else {
+      freeze(s[i].child);
+    }
+  }
+}
+
+void libbirch::MemoNode::mark_() {
+  auto s = slots();
+  for (auto i = 0u; i < nslots; ++i) {
+    Any* o = s[i].key ? s[i].value : s[i].child;
+    if (o) {
+      o->breakShared();  // break the reference
+      o->mark();
+    }
+  }
+}
+
+void libbirch::MemoNode::scan_() {
+  auto s = slots();
+  for (auto i = 0u; i < nslots; ++i) {
+    Any* o = s[i].key ? s[i].value : s[i].child;
+    if (o) {
+      o->scan();
+    }
+  }
+}
+
+void libbirch::MemoNode::reach_() {
+  auto s = slots();
+  for (auto i = 0u; i < nslots; ++i) {
+    Any* o = s[i].key ? s[i].value : s[i].child;
+    if (o) {
+      o->restoreShared();  // restore the broken reference
+      o->reach();
+    }
+  }
+}
+
+void libbirch::MemoNode::collect_() {
+  auto s = slots();
+  for (auto i = 0u; i < nslots; ++i) {
+    Any* o = nullptr;
+    if (s[i].key) {
+      o = s[i].value;
+      s[i].value = nullptr;
+    } else {
+      o = s[i].child;
+      s[i].child = nullptr;
+    }
+    if (o) {
+      o->collect();
+    }
+  }
+}
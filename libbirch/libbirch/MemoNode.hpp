@@ -0,0 +1,400 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "libbirch/Any.hpp"
+#include "libbirch/Allocator.hpp"
+#include "libbirch/Memo.hpp"
+
+namespace libbirch {
+/**
+ * Node of the hash array mapped trie (HAMT) that implements Memo.
+ *
+ * @ingroup libbirch
+ *
+ * Each node has up to 32 slots, indexed by five bits of the hash of a key:
+ * the most significant five bits at the root, the next five at its
+ * children, and so on. Each slot holds either an entry (a key and its value)
+ * or a child node. Only occupied slots are stored, in order, with a bitmap
+ * indicating which of the 32 are occupied. The slots follow the node in the
+ * same allocation.
+ *
+ * Nodes are never modified once they are reachable from the root of a
+ * trie, as concurrent readers may be visiting them (see Memo). A write
+ * instead replaces the nodes on the path from the root to the entries that
+ * it changes with new nodes (path copying), and retires the old nodes. A
+ * new node takes new references to the contents of an old node that is
+ * shared, but otherwise takes over its references, leaving the old node to
+ * be discarded.
+ *
+ * Nodes are also shared between memos, and so between labels, which makes
+ * the copy of a memo a constant-time operation. Nodes derive from Any so
+ * that the cycle collector traverses them like any other object, but with
+ * biased reference counting disabled, as whether or not a node is shared
+ * must be determined exactly.
+ *
+ * Nodes also use the finished and frozen flags of Any, so that finish() and
+ * freeze() visit only those nodes that have changed since they were last
+ * visited, which, for a memo shared with the label of a previous clone, are
+ * only those with entries added since: a new node starts with these flags
+ * cleared, and so do its ancestors, which are new too.
+ */
+class MemoNode final : public Any {
+public:
+  using key_type = Any*;
+  using value_type = Any*;
+
+  using Released = Memo::Released;
+
+  /**
+   * Get a value.
+   *
+   * @param node Root node, or null for an empty trie.
+   * @param key Key.
+   * @param[in,out] nprobes Incremented by the number of nodes visited.
+   *
+   * @return If @p key exists, then its associated value, otherwise null.
+   */
+  static value_type get(const MemoNode* node, const key_type key,
+      unsigned& nprobes);
+
+  /**
+   * Insert an entry.
+   *
+   * @param[in,out] node Root node, or null for an empty trie; updated to the
+   * new root node.
+   * @param key Key, which must not already exist.
+   * @param value Value.
+   * @param released Nodes replaced by new nodes.
+   *
+   * A memo reference to @p key and a shared reference to @p value pass from
+   * the caller to the trie.
+   */
+  static void insert(MemoNode*& node, const key_type key,
+      const value_type value, Released& released);
+
+  /**
+   * Replace the value of an entry.
+   *
+   * @param[in,out] node Root node; updated to the new root node.
+   * @param key Key, which must exist.
+   * @param value New value.
+   * @param released Nodes replaced by new nodes.
+   *
+   * @return Previous value.
+   *
+   * A shared reference to @p value passes from the caller to the trie, and
+   * that to the previous value from the trie to the caller.
+   */
+  static value_type replace(MemoNode*& node, const key_type key,
+      const value_type value, Released& released);
+
+  /**
+   * Apply the trie to the values of its own entries; this has the effect of
+   * replacing a -> b and b -> c with a -> c and b -> c, which may allow b to
+   * be collected sooner. Only nodes that are not shared are updated.
+   *
+   * @param[in,out] node Node; updated to a new node if it, or any of its
+   * descendants, is modified.
+   * @param root Root node of the trie, which is left unchanged.
+   * @param released References removed from the trie.
+   */
+  static void compress(MemoNode*& node, const MemoNode* root,
+      Released& released);
+
+  /**
+   * Remove entries where the key is no longer reachable. Only nodes that are
+   * not shared are updated.
+   *
+   * @param[in,out] node Node; updated to a new node if it, or any of its
+   * descendants, is modified, and null if it becomes empty.
+   * @param released References removed from the trie.
+   *
+   * @return Number of entries removed.
+   */
+  static unsigned prune(MemoNode*& node, Released& released);
+
+  /**
+   * Finish values, skipping nodes that are already finished.
+   *
+   * @param node Root node, or null for an empty trie.
+   * @param label Label.
+   */
+  static void finish(MemoNode* node, Label* label);
+
+  /**
+   * Freeze values, skipping nodes that are already frozen.
+   *
+   * @param node Root node, or null for an empty trie.
+   */
+  static void freeze(MemoNode* node);
+
+  /**
+   * Release a node that has been replaced by another, to which the contents
+   * of its slots have been moved.
+   */
+  static void discard(MemoNode* o);
+
+  /**
+   * Destructor.
+   */
+  virtual ~MemoNode();
+
+private:
+  /**
+   * Slot.
+   */
+  struct Slot {
+    /**
+     * Key, or null if the slot holds a child node.
+     */
+    key_type key;
+
+    union {
+      /**
+       * Value, if the slot holds an entry. May be null if collect() has
+       * already destroyed it.
+       */
+      value_type value;
+
+      /**
+       * Child node, if the slot holds a child node. May be null if collect()
+       * has already destroyed it.
+       */
+      MemoNode* child;
+    };
+  };
+
+  /**
+   * Constructor.
+   *
+   * @param capacity Number of slots allocated.
+   */
+  MemoNode(const unsigned capacity);
+
+  /**
+   * Allocate and construct a new node.
+   *
+   * @param capacity Number of slots to allocate.
+   */
+  static MemoNode* make(const unsigned capacity);
+
+  /**
+   * Allocate and construct a new node, with slots that are moved into it,
+   * along with their references.
+   *
+   * @param s Slots.
+   * @param bitmap Bitmap of the slots.
+   * @param nslots Number of slots.
+   * @param capacity Number of slots to allocate, at least @p nslots.
+   */
+  static MemoNode* make(const Slot* s, const uint32_t bitmap,
+      const unsigned nslots, const unsigned capacity);
+
+  /**
+   * Copy a node, taking new references for the contents of all slots.
+   *
+   * @param o Node.
+   * @param capacity Number of slots to allocate, at least as many as are
+   * occupied in @p o.
+   */
+  static MemoNode* make(const MemoNode* o, const unsigned capacity);
+
+  /**
+   * Allocate and construct a new node, at a level of the trie, that holds
+   * two entries, with child nodes as necessary to separate them. Their
+   * references are moved into the node.
+   */
+  static MemoNode* make(const key_type key1, const value_type value1,
+      const key_type key2, const value_type value2, const int level);
+
+  /**
+   * Replace a node with a new node, to be modified in its place, and retire
+   * the old node.
+   *
+   * @param o Node.
+   * @param capacity Number of slots to allocate, at least as many as are
+   * occupied in @p o.
+   * @param released Nodes replaced by new nodes, to which @p o is added.
+   *
+   * @return The new node, with a shared reference for the caller.
+   */
+  static MemoNode* renew(MemoNode* o, const unsigned capacity,
+      Released& released);
+
+  /**
+   * Compute the bit of the bitmap for a key at a level of the trie.
+   */
+  static unsigned bit(const key_type key, const int level);
+
+  /**
+   * Number of bytes that should be allocated for a node with @p capacity
+   * slots.
+   */
+  static size_t size(const unsigned capacity);
+
+  /**
+   * Is the node shared by more than one memo or parent node?
+   */
+  bool isShared() const;
+
+  /**
+   * Get the position in the slots of a bit of the bitmap.
+   */
+  unsigned position(const unsigned bit) const;
+
+  /**
+   * Get the position in the slots of a bit of a given bitmap.
+   */
+  static unsigned position(const uint32_t bitmap, const unsigned bit);
+
+  /**
+   * Get the slots.
+   */
+  Slot* slots();
+
+  /**
+   * Get the slots.
+   */
+  const Slot* slots() const;
+
+  /**
+   * Insert an entry at a level of the trie.
+   */
+  static void insert(MemoNode*& node, const key_type key,
+      const value_type value, const int level, Released& released);
+
+  /**
+   * Replace the value of an entry at a level of the trie.
+   */
+  static value_type replace(MemoNode*& node, const key_type key,
+      const value_type value, const int level, Released& released);
+
+  /**
+   * Bitmap of occupied slots.
+   */
+  uint32_t bitmap;
+
+  /**
+   * Number of occupied slots.
+   */
+  uint16_t nslots;
+
+  /**
+   * Number of allocated slots.
+   */
+  uint16_t capacity;
+
+  /**
+   * First slot. Taking the address of this gives a pointer to the start of
+   * the overallocated slots.
+   */
+  alignas(Slot) char first;
+
+public:
+  virtual const char* getClassName() const override {
+    return "MemoNode";
+  }
+
+  virtual unsigned size_() const override {
+    return size(capacity);
+  }
+
+  virtual void finish_(Label* label) override;
+  virtual void freeze_() override;
+
+  virtual MemoNode* copy_(Label* label) const override {
+    return make(this, capacity);
+  }
+
+  virtual void recycle_(Label* label) override {
+    //
+  }
+
+  virtual void mark_() override;
+  virtual void scan_() override;
+  virtual void reach_() override;
+  virtual void collect_() override;
+
+  virtual void discover_(const Discoverer& v) override {
+    //
+  }
+
+  virtual void copyEager_(const EagerCopier& v) override {
+    //
+  }
+
+  using base_type = Any;
+};
+
+template<unsigned N>
+struct is_acyclic_class<MemoNode,N> {
+  static const bool value = false;
+};
+}
+
+inline libbirch::MemoNode::value_type libbirch::MemoNode::get(
+    const MemoNode* node, const key_type key, unsigned& nprobes) {
+  assert(key);
+  int level = 0;
+  while (node) {
+    ++nprobes;
+    auto b = bit(key, level);
+    if (!(node->bitmap & (1u << b))) {
+      return nullptr;
+    }
+    auto& slot = node->slots()[node->position(b)];
+    if (slot.key) {
+      return (slot.key == key) ? slot.value : nullptr;
+    }
+    node = slot.child;
+    ++level;
+  }
+  return nullptr;
+}
+
+inline unsigned libbirch::MemoNode::bit(const key_type key,
+    const int level) {
+  /* multiplication by an odd constant is a bijection on 64-bit integers, so
+   * distinct keys always have distinct hashes, and the trie has a depth of
+   * at most 13 */
+  auto h = uint64_t(reinterpret_cast<uintptr_t>(key))*0x9e3779b97f4a7c15ull;
+  int shift = 59 - 5*level;
+  return unsigned((shift >= 0) ? (h >> shift) : (h << -shift)) & 31u;
+}
+
+inline size_t libbirch::MemoNode::size(const unsigned capacity) {
+  return sizeof(MemoNode) + capacity*sizeof(Slot);
+}
+
+inline bool libbirch::MemoNode::isShared() const {
+  return numShared() > 1u;
+}
+
+inline unsigned libbirch::MemoNode::position(const unsigned bit) const {
+  return position(bitmap, bit);
+}
+
+inline unsigned libbirch::MemoNode::position(const uint32_t bitmap,
+    const unsigned bit) {
+  uint32_t mask = bitmap & ((1u << bit) - 1u);
+  #ifdef HAVE___BUILTIN_POPCOUNT
+  return __builtin_popcount(mask);
+  #else
+  unsigned n = 0u;
+  while (mask) {
+    mask &= mask - 1u;
+    ++n;
+  }
+  return n;
+  #endif
+}
+
+inline libbirch::MemoNode::Slot* libbirch::MemoNode::slots() {
+  return reinterpret_cast<Slot*>(&first);
+}
+
+inline const libbirch::MemoNode::Slot* libbirch::MemoNode::slots() const {
+  return reinterpret_cast<const Slot*>(&first);
+}
@@ -8,7 +8,7 @@
 
 namespace libbirch {
 /**
- * Thread-safe stack of memory allocations.
+ * Per-thread stack of memory allocations.
  *
  * @ingroup libbirch
  *
@@ -16,7 +16,14 @@ namespace libbirch {
  * the stack, and returned to the pool by pushing the stack. As each
  * block is at least 8 bytes in size, when in the pool (and therefore
  * not in use), its first 8 bytes are used to store a pointer to the next
- * block on the stack. The implementation is lock-free.
+ * block on the stack.
+ *
+ * Each pool is owned by a single thread. Only the owning thread may call
+ * pop() and push(), which require no synchronization at all. Other threads
+ * return blocks with give(), which splices a whole batch of blocks onto a
+ * separate incoming stack under a lock. The owning thread only takes that
+ * lock when its own stack is empty, at which point it takes the entire
+ * incoming stack in one operation.
  */
 class Pool {
 public:
@@ -24,7 +31,8 @@ public:
    * Constructor.
    */
   Pool() :
-      top(nullptr) {
+      top(nullptr),
+      incoming(nullptr) {
     //
   }
 
@@ -32,32 +40,102 @@ public:
    * Is the pool empty?
    */
   bool empty() const {
-    return !top;
+    return !top && !incoming.load();
   }
 
   /**
    * Pop an allocation from the pool. Returns `nullptr` if the pool is
-   * empty.
+   * empty. Must only be called by the owning thread.
    */
   void* pop() {
-    lock.set();
+    if (!top) {
+      drain();
+    }
     auto result = top;
     top = getNext(result);
-    lock.unset();
     return result;
   }
 
   /**
-   * Push an allocation to the pool.
+   * Push an allocation to the pool. Must only be called by the owning
+   * thread.
    */
   void push(void* block) {
-    lock.set();
     setNext(block, top);
     top = block;
+  }
+
+  /**
+   * Push a batch of allocations to the pool from a thread other than the
+   * owning thread.
+   *
+   * @param first First block of the batch.
+   * @param last Last block of the batch.
+   *
+   * The blocks of the batch must already be linked through their first 8
+   * bytes, from @p first to @p last.
+   */
+  void give(void* first, void* last) {
+    assert(first);
+    assert(last);
+    lock.set();
+    setNext(last, incoming.load());
+    incoming.store(first);
+    lock.unset();
+  }
+
+  /**
+   * Remove all blocks for which a predicate is true. Must only be called by
+   * the owning thread, and only while no other thread may call give().
+   *
+   * @param f Predicate, taking a block as argument.
+   */
+  template<class Predicate>
+  void removeIf(const Predicate& f) {
+    /* filter the stack, then append the incoming stack and filter that */
+    auto end = filter(&top, f);
+    lock.set();
+    *end = incoming.load();
+    incoming.store(nullptr);
     lock.unset();
+    filter(end, f);
   }
 
 private:
+  /**
+   * Move all blocks from the incoming stack to the owning thread's stack.
+   */
+  void drain() {
+    if (incoming.load()) {
+      lock.set();
+      top = incoming.load();
+      incoming.store(nullptr);
+      lock.unset();
+    }
+  }
+
+  /**
+   * Remove all blocks for which a predicate is true from a stack.
+   *
+   * @param prev Pointer to the top of the stack.
+   * @param f Predicate, taking a block as argument.
+   *
+   * @return Pointer to the next pointer of the last remaining block, or
+   * @p prev if none remain.
+   */
+  template<class Predicate>
+  static void** filter(void** prev, const Predicate& f) {
+    while (*prev) {
+      auto block = *prev;
+      if (f(block)) {
+        *prev = getNext(block);
+      } else {
+        prev = reinterpret_cast<void**>(block);
+      }
+    }
+    return prev;
+  }
+
   /**
    * Get the first 8 bytes of a block as a pointer.
    */
@@ -74,12 +152,18 @@ private:
   }
 
   /**
-   * Stack of allocations.
+   * Stack of allocations, accessed by the owning thread only.
    */
   void* top;
 
   /**
-   * Mutex.
+   * Stack of allocations returned by other threads. This is aligned to keep
+   * it on a separate cache line to the owning thread's stack.
+   */
+  alignas(64) Atomic<void*> incoming;
+
+  /**
+   * Mutex for the incoming stack.
    */
   Lock lock;
 };
@@ -56,7 +56,7 @@ public:
    */
   template<class T, class F>
   void visit(Array<T,F>& o) const {
-    o.accept_(*this);
+    o.reach(*this);
   }
 
   /**
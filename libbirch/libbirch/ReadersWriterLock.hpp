@@ -73,6 +73,9 @@ inline libbirch::ReadersWriterLock::ReadersWriterLock() :
 }
 
 inline void libbirch::ReadersWriterLock::setRead() {
+  /* the increment of readers and load of writer here, and the exchange of
+   * writer and load of readers in setWrite(), must remain sequentially
+   * consistent, so that a reader and writer cannot both miss each other */
   readers.increment();
   while (writer.load()) {
     //
@@ -80,7 +83,7 @@ inline void libbirch::ReadersWriterLock::setRead() {
 }
 
 inline void libbirch::ReadersWriterLock::unsetRead() {
-  readers.decrement();
+  readers.decrementRelease();
 }
 
 inline void libbirch::ReadersWriterLock::setWrite() {
@@ -94,16 +97,16 @@ inline void libbirch::ReadersWriterLock::setWrite() {
      * from the start, otherwise proceed */
     w = (readers.load() == 0);
     if (!w) {
-      writer.store(false);
+      writer.storeRelease(false);
     }
   } while (!w);
 }
 
 inline void libbirch::ReadersWriterLock::unsetWrite() {
-  writer.store(false);
+  writer.storeRelease(false);
 }
 
 inline void libbirch::ReadersWriterLock::downgrade() {
-  readers.increment();
-  writer.store(false);
+  readers.incrementRelaxed();
+  writer.storeRelease(false);
 }
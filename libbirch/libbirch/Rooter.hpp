@@ -0,0 +1,87 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "libbirch/type.hpp"
+
+namespace libbirch {
+template<class... Args> class Tuple;
+template<class T, class F> class Array;
+template<class T> class Optional;
+template<class P> class Lazy;
+
+/**
+ * Visitor for registering the referents of pointers as possible roots for
+ * cycle collection. This is used when an array gives up its use of a buffer
+ * that other arrays continue to share, so that the references held by the
+ * elements are not released, but would have been had the buffer not been
+ * shared (@see Buffer::isMarkedShared()).
+ *
+ * Unlike the other visitors, this is used by Array itself, so only declares
+ * the types that it visits, rather than including their headers.
+ *
+ * @ingroup libbirch
+ */
+class Rooter {
+public:
+  /**
+   * Visit list of variables.
+   *
+   * @param arg First variable.
+   * @param args... Remaining variables.
+   */
+  template<class Arg, class... Args>
+  void visit(Arg& arg, Args&... args) const {
+    visit(arg);
+    visit(args...);
+  }
+
+  /**
+   * Visit empty list of variables (base case).
+   */
+  void visit() const {
+    //
+  }
+
+  /**
+   * Visit a value.
+   */
+  template<class T, std::enable_if_t<is_value<T>::value,int> = 0>
+  void visit(T& arg) const {
+    //
+  }
+
+  /**
+   * Visit a tuple.
+   */
+  template<class Head, class... Tail>
+  void visit(Tuple<Head,Tail...>& o) const {
+    o.accept_(*this);
+  }
+
+  /**
+   * Visit an array.
+   */
+  template<class T, class F>
+  void visit(Array<T,F>& o) const {
+    o.accept_(*this);
+  }
+
+  /**
+   * Visit an optional.
+   */
+  template<class T>
+  void visit(Optional<T>& o) const {
+    o.accept_(*this);
+  }
+
+  /**
+   * Visit a lazy pointer.
+   */
+  template<class P>
+  void visit(Lazy<P>& o) const {
+    o.possibleRoot();
+  }
+};
+}
@@ -7,6 +7,7 @@
 #include "libbirch/Array.hpp"
 #include "libbirch/Optional.hpp"
 #include "libbirch/Lazy.hpp"
+#include "libbirch/Reacher.hpp"
 
 namespace libbirch {
 /**
@@ -56,7 +57,7 @@ public:
    */
   template<class T, class F>
   void visit(Array<T,F>& o) const {
-    o.accept_(*this);
+    o.scan(*this, Reacher());
   }
 
   /**
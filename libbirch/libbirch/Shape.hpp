@@ -300,4 +300,48 @@ template<>
 struct DefaultShape<0> {
   typedef EmptyShape type;
 };
+
+/**
+ * Shape with static lengths, and the strides of contiguous storage in row
+ * major order.
+ *
+ * @tparam Lengths Length of each dimension.
+ */
+template<int64_t... Lengths>
+struct StaticShape;
+
+template<int64_t Length, int64_t... Lengths>
+struct StaticShape<Length,Lengths...> {
+  typedef StaticShape<Lengths...> tail_type;
+  typedef Shape<Dimension<Length,tail_type::volume>,typename tail_type::type>
+      type;
+
+  /**
+   * Length of the first dimension.
+   */
+  static constexpr int64_t length = Length;
+
+  /**
+   * Number of elements.
+   */
+  static constexpr int64_t volume = Length*tail_type::volume;
+
+  /**
+   * Make the shape. Its lengths and strides are static, so this has no
+   * run-time cost.
+   */
+  static type make() {
+    return type(Dimension<Length,tail_type::volume>(Length,
+        tail_type::volume), tail_type::make());
+  }
+};
+
+template<>
+struct StaticShape<> {
+  typedef EmptyShape type;
+  static constexpr int64_t volume = 1;
+  static type make() {
+    return EmptyShape();
+  }
+};
 }
@@ -37,11 +37,11 @@ public:
    * Copy constructor.
    */
   Shared(const Shared& o) {
-    auto ptr = o.ptr.load();
+    auto ptr = o.ptr.loadAcquire();
     if (ptr) {
       ptr->incShared();
     }
-    this->ptr.store(ptr);
+    this->ptr.storeRelaxed(ptr);
   }
 
   /**
@@ -49,11 +49,11 @@ public:
    */
   template<class U, std::enable_if_t<std::is_base_of<T,U>::value,int> = 0>
   Shared(const Shared<U>& o) {
-    auto ptr = o.ptr.load();
+    auto ptr = o.ptr.loadAcquire();
     if (ptr) {
       ptr->incShared();
     }
-    this->ptr.store(ptr);
+    this->ptr.storeRelaxed(ptr);
   }
 
   /**
@@ -61,18 +61,18 @@ public:
    */
   template<class Q, std::enable_if_t<std::is_base_of<T,typename Q::value_type>::value,int> = 0>
   Shared(const Q& o) {
-    auto ptr = o.ptr.load();
+    auto ptr = o.ptr.loadAcquire();
     if (ptr) {
       ptr->incShared();
     }
-    this->ptr.store(ptr);
+    this->ptr.storeRelaxed(ptr);
   }
 
   /**
    * Move constructor.
    */
   Shared(Shared&& o) {
-    ptr.store(o.ptr.exchange(nullptr));
+    ptr.storeRelaxed(o.ptr.exchange(nullptr));
   }
 
   /**
@@ -80,7 +80,7 @@ public:
    */
   template<class U, std::enable_if_t<std::is_base_of<T,U>::value,int> = 0>
   Shared(Shared<U>&& o) {
-    ptr.store(o.ptr.exchange(nullptr));
+    ptr.storeRelaxed(o.ptr.exchange(nullptr));
   }
 
   /**
@@ -136,7 +136,7 @@ public:
       if (ptr == old) {
         old->decSharedReachable();
       } else if (is_acyclic<Shared<T>>::value) {
-        old->decSharedAcyclic();
+        old->decSharedAcyclicClass();
       } else {
         old->decShared();
       }
@@ -155,7 +155,7 @@ public:
       if (ptr == old) {
         old->decSharedReachable();
       } else if (is_acyclic<Shared<T>>::value) {
-        old->decSharedAcyclic();
+        old->decSharedAcyclicClass();
       } else {
         old->decShared();
       }
@@ -170,14 +170,14 @@ public:
    * conversion operators in the referent type.
    */
   bool query() const {
-    return ptr.load() != nullptr;
+    return ptr.loadAcquire() != nullptr;
   }
 
   /**
    * Get the raw pointer.
    */
   T* get() const {
-    return ptr.load();
+    return ptr.loadAcquire();
   }
 
   /**
@@ -192,7 +192,7 @@ public:
       if (ptr == old) {
         old->decSharedReachable();
       } else if (is_acyclic<Shared<T>>::value) {
-        old->decSharedAcyclic();
+        old->decSharedAcyclicClass();
       } else {
         old->decShared();
       }
@@ -206,7 +206,7 @@ public:
     auto old = ptr.exchange(nullptr);
     if (old) {
       if (is_acyclic<Shared<T>>::value) {
-        old->decSharedAcyclic();
+        old->decSharedAcyclicClass();
       } else {
         old->decShared();
       }
@@ -227,16 +227,29 @@ public:
     return get();
   }
 
+  /**
+   * Register the referent as a possible root for cycle collection, or its
+   * label if it is of acyclic class (see Any::decSharedAcyclicClass()).
+   */
+  void possibleRoot() {
+    auto o = ptr.loadRelaxed();
+    if (o) {
+      if (is_acyclic<Shared<T>>::value) {
+        o->labelPossibleRoot();
+      } else {
+        o->Any::possibleRoot();
+      }
+    }
+  }
+
   /**
    * Mark.
    */
   void mark() {
-    if (!is_acyclic<Shared<T>>::value) {
-      auto o = ptr.load();
-      if (o) {
-        o->decSharedReachable();  // break the reference
-        o->Any::mark();
-      }
+    auto o = ptr.loadRelaxed();
+    if (o) {
+      o->breakShared();  // break the reference
+      o->Any::mark();
     }
   }
 
@@ -244,11 +257,9 @@ public:
    * Scan.
    */
   void scan() {
-    if (!is_acyclic<Shared<T>>::value) {
-      auto o = ptr.load();
-      if (o) {
-        o->Any::scan();
-      }
+    auto o = ptr.loadRelaxed();
+    if (o) {
+      o->Any::scan();
     }
   }
 
@@ -256,12 +267,10 @@ public:
    * Reach.
    */
   void reach() {
-    if (!is_acyclic<Shared<T>>::value) {
-      auto o = ptr.load();
-      if (o) {
-        o->incShared();  // restore the broken reference
-        o->Any::reach();
-      }
+    auto o = ptr.loadRelaxed();
+    if (o) {
+      o->restoreShared();  // restore the broken reference
+      o->Any::reach();
     }
   }
 
@@ -269,11 +278,9 @@ public:
    * Collect.
    */
   void collect() {
-    if (!is_acyclic<Shared<T>>::value) {
-      auto o = ptr.exchange(nullptr);  // reference still broken, just set null
-      if (o) {
-        o->Any::collect();
-      }
+    auto o = ptr.exchange(nullptr);  // reference still broken, just set null
+    if (o) {
+      o->Any::collect();
     }
   }
 
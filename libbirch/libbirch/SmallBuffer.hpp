@@ -0,0 +1,97 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "libbirch/external.hpp"
+
+namespace libbirch {
+/**
+ * Room for the elements of a small array within the array, for arrays of
+ * arithmetic type, so that they need not allocate a buffer. Short vectors
+ * and small matrices are common as the state of models, and as temporaries
+ * in arithmetic on them.
+ *
+ * Only the elements themselves are stored, with none of the header of a
+ * Buffer: a small buffer is never shared, so needs no usage count, and its
+ * capacity is fixed. A view of a small array, which has no room of its own,
+ * keeps a pointer to the elements of that array in the same space instead.
+ *
+ * For other types there is no room (capacity is zero). As the array does
+ * not keep a pointer to its own small buffer, arrays containing it may
+ * still be moved bitwise.
+ *
+ * @ingroup libbirch
+ *
+ * @tparam T Value type.
+ */
+template<class T, class Enable = void>
+class SmallBuffer {
+public:
+  /**
+   * Number of elements for which there is room.
+   */
+  static constexpr int64_t capacity = 0;
+
+  /**
+   * Get the elements, for an array.
+   */
+  T* buf() {
+    return nullptr;
+  }
+
+  /**
+   * Get the elements of the viewed array, for a view.
+   */
+  T* viewed() {
+    return nullptr;
+  }
+
+  /**
+   * Set the elements of the viewed array, for a view.
+   */
+  void view(T* elements) {
+    assert(!elements);
+  }
+};
+
+template<class T>
+class SmallBuffer<T,std::enable_if_t<std::is_arithmetic<T>::value>> {
+public:
+  static constexpr int64_t capacity = 32/sizeof(T);
+
+  T* buf() {
+    return reinterpret_cast<T*>(bytes);
+  }
+
+  T* viewed() {
+    return elements;
+  }
+
+  void view(T* elements) {
+    this->elements = elements;
+  }
+
+private:
+  static_assert(capacity*sizeof(T) < 64u,
+      "elements of a small buffer should not need alignment to cache lines");
+
+  union {
+    /**
+     * Storage for the elements, for an array.
+     */
+    alignas(T) char bytes[capacity*sizeof(T)];
+
+    /**
+     * Elements of the viewed array, for a view.
+     */
+    T* elements;
+  };
+};
+
+template<class T, class Enable>
+constexpr int64_t SmallBuffer<T,Enable>::capacity;
+
+template<class T>
+constexpr int64_t SmallBuffer<T,std::enable_if_t<std::is_arithmetic<T>::value>>::capacity;
+}
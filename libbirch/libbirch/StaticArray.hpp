@@ -0,0 +1,175 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "libbirch/Array.hpp"
+
+namespace libbirch {
+/**
+ * Array with lengths known at compile time, for variables declared with
+ * literal sizes, e.g. `x:Real[3]`.
+ *
+ * @ingroup libbirch
+ *
+ * @tparam T Value type.
+ * @tparam Lengths Length of each dimension.
+ *
+ * This is an array with the default shape, so that it may be used wherever
+ * one is expected, including to deduce the template arguments of generic
+ * functions. Through it, however, element offsets are computed with the
+ * static shape, so that they fold to constants, and small arrays map to
+ * fixed-size Eigen types, which need no allocation and may be unrolled.
+ *
+ * The lengths cannot change: assigning an array of other lengths is an
+ * error, checked in release builds too, as resizing would leave element
+ * access using the static shape out of bounds. The driver therefore uses a
+ * static array only for a local variable that is not assigned as a whole
+ * after its declaration.
+ */
+template<class T, int64_t... Lengths>
+class StaticArray : public DefaultArray<T,sizeof...(Lengths)> {
+public:
+  using super_type = DefaultArray<T,sizeof...(Lengths)>;
+  using static_shape_type = StaticShape<Lengths...>;
+
+  static_assert(sizeof...(Lengths) == 1 || sizeof...(Lengths) == 2,
+      "static arrays must have one or two dimensions");
+
+  /**
+   * Largest number of elements for which a fixed-size Eigen type is used.
+   * Larger fixed-size Eigen types may be evaluated into temporaries on the
+   * stack, so dynamic types are used for them.
+   */
+  static constexpr int64_t MAX_FIXED_VOLUME = 16;
+
+  /**
+   * Constructor.
+   *
+   * @tparam Args Constructor parameter types.
+   *
+   * @param shape Shape. Its lengths must be the static lengths.
+   * @param args Constructor arguments.
+   */
+  template<class... Args>
+  StaticArray(const typename super_type::shape_type& shape, Args... args) :
+      super_type(shape, args...) {
+    checkConforms();
+  }
+
+  /**
+   * Conversion constructor.
+   *
+   * @param o Array with the static lengths.
+   */
+  StaticArray(const super_type& o) :
+      super_type(o) {
+    checkConforms();
+  }
+
+  /**
+   * Copy assignment. The lengths of the array must be the static lengths.
+   */
+  StaticArray& operator=(const super_type& o) {
+    libbirch_error_msg_(o.shape.conforms(static_shape_type::make()),
+        "array sizes are different");
+    super_type::operator=(o);
+    checkConforms();
+    return *this;
+  }
+
+  /**
+   * @name Element access, caller not responsible for thread safety
+   */
+  ///@{
+  template<class V, class U, std::enable_if_t<V::rangeCount() != 0,int> = 0>
+  auto set(const V& slice, const U& value) {
+    return super_type::set(slice, value);
+  }
+
+  template<class V, class U, std::enable_if_t<V::rangeCount() == 0,int> = 0>
+  T& set(const V& slice, const U& value) {
+    this->pinWrite();
+    auto& o = (*(this->buf() + static_shape_type::make().serial(slice)) =
+        value);
+    this->unpin();
+    return o;
+  }
+
+  template<class V, std::enable_if_t<V::rangeCount() != 0,int> = 0>
+  auto get(const V& slice) const {
+    return super_type::get(slice);
+  }
+
+  template<class V, std::enable_if_t<V::rangeCount() == 0,int> = 0>
+  const T& get(const V& slice) const {
+    return *(this->buf() + static_shape_type::make().serial(slice));
+  }
+  ///@}
+
+  /**
+   * @name Eigen integration
+   */
+  ///@{
+  template<class U = T, std::enable_if_t<is_value<U>::value &&
+      static_shape_type::volume <= MAX_FIXED_VOLUME,int> = 0>
+  auto toEigen() {
+    return eigen_fixed_type(this->buf());
+  }
+
+  template<class U = T, std::enable_if_t<is_value<U>::value &&
+      static_shape_type::volume <= MAX_FIXED_VOLUME,int> = 0>
+  auto toEigen() const {
+    return eigen_fixed_type(this->buf());
+  }
+
+  template<class U = T, std::enable_if_t<is_value<U>::value &&
+      (static_shape_type::volume > MAX_FIXED_VOLUME),int> = 0>
+  auto toEigen() {
+    return super_type::toEigen();
+  }
+
+  template<class U = T, std::enable_if_t<is_value<U>::value &&
+      (static_shape_type::volume > MAX_FIXED_VOLUME),int> = 0>
+  auto toEigen() const {
+    return super_type::toEigen();
+  }
+  ///@}
+
+private:
+  /**
+   * Fixed-size Eigen type. A static array is not a view, so its elements are
+   * contiguous.
+   */
+  using eigen_fixed_type = EigenFixedMap<T,int(static_shape_type::length),
+      int(static_shape_type::volume/static_shape_type::length)>;
+
+  /**
+   * Check that the lengths and strides are those of the static shape, as
+   * element access assumes.
+   */
+  void checkConforms() const {
+    auto shape = static_shape_type::make();
+    bool conforms = true;
+    for (int i = 0; i < int(sizeof...(Lengths)); ++i) {
+      conforms = conforms && this->shape.length(i) == shape.length(i) &&
+          this->shape.stride(i) == shape.stride(i);
+    }
+    libbirch_error_msg_(conforms,
+        "array sizes are different from those declared");
+  }
+};
+
+template<class T, int64_t... Lengths>
+constexpr int64_t StaticArray<T,Lengths...>::MAX_FIXED_VOLUME;
+
+template<class T, int64_t... Lengths>
+struct is_value<StaticArray<T,Lengths...>> {
+  static const bool value = is_value<T>::value;
+};
+
+template<class T, int64_t... Lengths, unsigned N>
+struct is_acyclic<StaticArray<T,Lengths...>,N> {
+  static const bool value = is_acyclic<T,N>::value;
+};
+}
@@ -64,6 +64,14 @@
   \
   virtual void collect_() override { \
     this->accept_(libbirch::Collector()); \
+  } \
+  \
+  virtual void discover_(const libbirch::Discoverer& v_) override { \
+    this->accept_(v_); \
+  } \
+  \
+  virtual void copyEager_(const libbirch::EagerCopier& v_) override { \
+    this->accept_(v_); \
   }
 
 /**
@@ -100,7 +108,7 @@
   } \
   \
   auto shared_from_this_() { \
-    return libbirch::Lazy<libbirch::Shared<Name>>(this); \
+    return libbirch::Lazy<libbirch::Shared<Name>>(this, this->getLabel()); \
   } \
   \
   template<class Visitor> \
@@ -120,7 +128,7 @@
   } \
   \
   auto shared_from_this_() { \
-    return libbirch::Lazy<libbirch::Shared<Name>>(this); \
+    return libbirch::Lazy<libbirch::Shared<Name>>(this, this->getLabel()); \
   } \
   \
   template<class Visitor> \
@@ -160,3 +168,5 @@
 #include "libbirch/Scanner.hpp"
 #include "libbirch/Reacher.hpp"
 #include "libbirch/Collector.hpp"
+#include "libbirch/Discoverer.hpp"
+#include "libbirch/EagerCopier.hpp"
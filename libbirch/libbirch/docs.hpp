@@ -38,6 +38,13 @@
  * these during its own cleanup operations if no other shared or weak pointers
  * exist to an object.
  *
+ * The shared count is *biased* toward the thread that allocated the object,
+ * after @ref Choi2018 "Choi, Shull & Torrellas (2018)": that thread updates a
+ * local part of the count without atomic operations, while other threads
+ * update a shared part atomically. The two are merged once the owning thread
+ * gives up its references, or, if other threads give up references counted
+ * in the local part, at the next cycle collection.
+ *
  * ## Cycle collection
  *
  * Shared and Weak pointers are can be insufficient, and user-programmed logic
@@ -59,4 +66,11 @@
  * D.F. Bacon and V.T. Rajan (2001). [Concurrent Cycle Collection in
  * Reference Counted Systems](https://dx.doi.org/10.1007/3-540-45337-7_12).
  * *ECOOP 2001 --- Object-Oriented Programming*. 207--235.
+ *
+ * @anchor Choi2018
+ * J. Choi, T. Shull and J. Torrellas (2018). [Biased Reference Counting:
+ * Minimizing Atomic Operations in Garbage
+ * Collection](https://doi.org/10.1145/3243176.3243195). *PACT '18:
+ * Proceedings of the 27th International Conference on Parallel Architectures
+ * and Compilation Techniques*.
  */
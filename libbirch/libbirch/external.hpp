@@ -11,6 +11,7 @@
 #include <utility>
 #include <functional>
 #include <vector>
+#include <unordered_map>
 #include <memory>
 #include <string>
 #include <sstream>
@@ -23,6 +24,7 @@
 #include <cstddef>
 #include <cmath>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <getopt.h>
 #include <dlfcn.h>
 
@@ -10,6 +10,8 @@
 #include "libbirch/assert.hpp"
 #include "libbirch/thread.hpp"
 #include "libbirch/memory.hpp"
+#include "libbirch/stats.hpp"
+#include "libbirch/profile.hpp"
 #include "libbirch/stacktrace.hpp"
 #include "libbirch/class.hpp"
 #include "libbirch/type.hpp"
@@ -23,6 +25,7 @@
 #include "libbirch/Shape.hpp"
 #include "libbirch/Slice.hpp"
 #include "libbirch/Array.hpp"
+#include "libbirch/StaticArray.hpp"
 #include "libbirch/Tuple.hpp"
 #include "libbirch/Any.hpp"
 #include "libbirch/Nil.hpp"
@@ -8,6 +8,9 @@
 #include "libbirch/Any.hpp"
 #include "libbirch/Label.hpp"
 #include "libbirch/Shared.hpp"
+#include "libbirch/stats.hpp"
+
+#include <chrono>
 
 /**
  * Type for object lists in cycle collection.
@@ -15,12 +18,19 @@
 using object_list = std::vector<libbirch::Any*,libbirch::Allocator<libbirch::Any*>>;
 
 /**
- * Get the possible roots list for the current thread.
+ * Get the possible roots list for thread `tid`.
  */
-static object_list& get_thread_possible_roots() {
+static object_list& get_possible_roots(const int tid) {
   static std::vector<object_list,libbirch::Allocator<object_list>> objects(
       libbirch::get_max_threads());
-  return objects[libbirch::get_thread_num()];
+  return objects[tid];
+}
+
+/**
+ * Get the possible roots list for the current thread.
+ */
+static object_list& get_thread_possible_roots() {
+  return get_possible_roots(libbirch::get_thread_num());
 }
 
 /**
@@ -33,29 +43,87 @@ static object_list& get_thread_unreachable() {
 }
 
 /**
- * Make the heap.
+ * Objects awaiting a merge of their shared count by their owning thread.
+ * Other threads register objects here, so access is locked. The owning
+ * thread merges them when it next allocates an object, at the start of the
+ * next cycle collection, or at exit, whichever comes first.
  */
-static char* make_heap() {
-  #ifdef DISABLE_MEMORY_POOL
-  return nullptr;
-  #else
-  /* determine a preferred size of the heap based on total physical memory */
-  size_t size = sysconf(_SC_PAGE_SIZE);
-  size_t npages = sysconf(_SC_PHYS_PAGES);
-  size_t n = 8u*npages*size;
+struct alignas(64) MergeQueue {
+  /**
+   * Lock.
+   */
+  libbirch::Lock lock;
 
-  /* attempt to allocate this amount, successively halving until
-   * successful */
-  void* ptr = nullptr;
-  int res = 0;
-  do {
-    res = posix_memalign(&ptr, 64ull, n);
-    n >>= 1;
-  } while (res > 0 && n > 0u);
-  assert(ptr);
+  /**
+   * Objects.
+   */
+  object_list objects;
 
-  return (char*)ptr;
-  #endif
+  /**
+   * Are there objects in the queue? This is set by other threads and
+   * cleared by the owning thread, so that the owning thread can check for
+   * objects without taking the lock.
+   */
+  libbirch::Atomic<bool> pending;
+
+  /**
+   * Is the owning thread merging the objects? Merging destroys objects,
+   * which must not start another merge.
+   */
+  bool merging;
+};
+
+/**
+ * Make the merge queues of all threads.
+ */
+static MergeQueue* make_merge_queues() {
+  /* queues are never freed, as they are used at exit (see
+   * release_at_exit()) */
+  size_t n = libbirch::get_max_threads();
+  auto queues = libbirch::make_thread_array<MergeQueue>(n);
+  for (size_t i = 0; i < n; ++i) {
+    queues[i].pending.store(false);
+    queues[i].merging = false;
+  }
+  return queues;
+}
+
+/**
+ * Get the merge queue for thread `tid`.
+ */
+static MergeQueue& get_merge_queue(const int tid) {
+  static MergeQueue* queues = make_merge_queues();
+  return queues[tid];
+}
+
+/**
+ * Merge the objects of the merge queue of thread `tid`. Must only be called
+ * by that thread, or outside of any parallel region (@see Any::merge()).
+ */
+static void merge_queue(const int tid) {
+  auto& queue = get_merge_queue(tid);
+  if (queue.pending.loadRelaxed() && !queue.merging) {
+    queue.merging = true;
+    object_list merges;
+    queue.lock.set();
+    merges.swap(queue.objects);
+    queue.pending.storeRelaxed(false);
+    queue.lock.unset();
+    for (auto& o : merges) {
+      if (!o->isDestroyed()) {
+        o->merge();
+      }
+      o->decMemo();
+    }
+    queue.merging = false;
+  }
+}
+
+/**
+ * Merge the objects of the merge queue of the current thread.
+ */
+static void merge_queue() {
+  merge_queue(libbirch::get_thread_num());
 }
 
 /**
@@ -67,24 +135,414 @@ static libbirch::Label* make_root() {
 
 libbirch::ExitBarrierLock libbirch::finish_lock;
 libbirch::ExitBarrierLock libbirch::freeze_lock;
+libbirch::Atomic<bool> libbirch::collect_due(false);
 
 /**
- * Get the heap.
+ * Thresholds for automatic cycle collection. See set_collect_threshold().
  */
-inline libbirch::Atomic<char*>& heap() {
-  static libbirch::Atomic<char*> heap(make_heap());
-  return heap;
+static libbirch::Atomic<size_t> collect_nroots(1ull << 20ull);
+static libbirch::Atomic<size_t> collect_nbytes(1ull << 30ull);
+
+/**
+ * Budget for automatic cycle collection. See set_collect_budget().
+ */
+static libbirch::Atomic<size_t> collect_budget(0u);
+
+/**
+ * Size of a chunk. Chunks are mapped from the operating system aligned to
+ * this size, so that the chunk containing any block can be found by masking
+ * the address of the block. This is also the size of a transparent huge
+ * page on most systems.
+ */
+static const size_t CHUNK_SIZE = 2ull << 20ull;
+
+/**
+ * Size of the header at the start of each chunk. This preserves the 64-byte
+ * alignment of the blocks that follow.
+ */
+static const size_t CHUNK_HEADER_SIZE = 64ull;
+
+/**
+ * Allocations larger than this are not served from chunks, but are mapped
+ * from the operating system individually, and unmapped on deallocation.
+ */
+static const size_t LARGE_SIZE = 128ull << 10ull;
+
+/**
+ * Header at the start of each chunk.
+ */
+struct Chunk {
+  /**
+   * Next chunk of the same thread.
+   */
+  Chunk* next;
+
+  /**
+   * Number of blocks allocated from the chunk and not yet deallocated. It
+   * is updated with relaxed ordering on allocation and deallocation, and
+   * read with acquire ordering only by release_chunks(), where a count of
+   * zero decides whether the chunk is unmapped; that runs while no other
+   * thread is allocating or deallocating, so the synchronization of that
+   * point orders the updates.
+   */
+  libbirch::Atomic<unsigned> nlive;
+
+  /**
+   * Id of the thread that owns the chunk. Blocks from the chunk are only
+   * ever allocated by this thread, and only ever returned to its pools.
+   */
+  int tid;
+};
+
+/**
+ * Chunks and bump allocation state of a thread.
+ */
+struct ThreadHeap {
+  /**
+   * All chunks of the thread, as a linked list.
+   */
+  Chunk* chunks;
+
+  /**
+   * Chunk from which new blocks are currently bump allocated.
+   */
+  Chunk* current;
+
+  /**
+   * Next unallocated byte in the current chunk.
+   */
+  char* bump;
+
+  /**
+   * A released chunk that has had its pages returned to the operating
+   * system, but is kept mapped for reuse.
+   */
+  Chunk* spare;
+};
+
+/**
+ * Counts of bytes obtained from the operating system.
+ */
+struct HeapUsage {
+  /**
+   * Lock.
+   */
+  libbirch::Lock lock;
+
+  /**
+   * Number of bytes currently in use.
+   */
+  size_t current = 0u;
+
+  /**
+   * Maximum number of bytes in use at any one time.
+   */
+  size_t peak = 0u;
+
+  /**
+   * Number of bytes in use at the end of the last cycle collection.
+   */
+  size_t collected = 0u;
+};
+
+/**
+ * Get the counts of bytes obtained from the operating system.
+ */
+inline HeapUsage& usage() {
+  static HeapUsage usage;
+  return usage;
+}
+
+/**
+ * Update the counts of bytes obtained from the operating system.
+ *
+ * @param n Number of bytes obtained (positive) or returned (negative).
+ */
+static void update_usage(const ptrdiff_t n) {
+  auto& u = usage();
+  u.lock.set();
+  u.current += n;
+  u.peak = std::max(u.peak, u.current);
+  auto nbytes = collect_nbytes.loadRelaxed();
+  if (n > 0 && nbytes > 0u && u.current >= u.collected + nbytes) {
+    libbirch::collect_due.storeRelaxed(true);
+  }
+  u.lock.unset();
+}
+
+/**
+ * Get the heap of thread `tid`.
+ */
+inline ThreadHeap& thread_heap(const int tid) {
+  static ThreadHeap* heaps = static_cast<ThreadHeap*>(std::calloc(
+      libbirch::get_max_threads(), sizeof(ThreadHeap)));
+  return heaps[tid];
+}
+
+/**
+ * Get the chunk containing a block.
+ */
+inline Chunk* chunk(void* block) {
+  return reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(block) &
+      ~(CHUNK_SIZE - 1ull));
+}
+
+/**
+ * Round a number of bytes up to a whole number of pages.
+ */
+inline size_t round_pages(const size_t n) {
+  static const size_t page = sysconf(_SC_PAGE_SIZE);
+  return (n + page - 1ull) & ~(page - 1ull);
+}
+
+/**
+ * Map memory from the operating system.
+ *
+ * @param n Number of bytes, a multiple of the page size.
+ */
+static char* map(const size_t n) {
+  void* ptr = mmap(nullptr, n, PROT_READ|PROT_WRITE,
+      MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+  libbirch_error_msg_(ptr != MAP_FAILED, "out of memory");
+  return static_cast<char*>(ptr);
+}
+
+/**
+ * Map a new chunk from the operating system.
+ */
+static Chunk* map_chunk() {
+  /* over-map, then trim to obtain the required alignment */
+  auto raw = map(2ull*CHUNK_SIZE);
+  auto aligned = reinterpret_cast<char*>(chunk(raw + CHUNK_SIZE - 1ull));
+  if (aligned > raw) {
+    munmap(raw, aligned - raw);
+  }
+  munmap(aligned + CHUNK_SIZE, raw + CHUNK_SIZE - aligned);
+  #if ENABLE_HUGE_PAGES && defined(MADV_HUGEPAGE)
+  madvise(aligned, CHUNK_SIZE, MADV_HUGEPAGE);
+  #endif
+  update_usage(CHUNK_SIZE);
+  return reinterpret_cast<Chunk*>(aligned);
+}
+
+/**
+ * Start a new chunk for bump allocation on the current thread.
+ */
+static void new_chunk(ThreadHeap& h, const int tid) {
+  Chunk* c = h.spare;
+  if (c) {
+    h.spare = nullptr;
+    update_usage(CHUNK_SIZE);
+  } else {
+    c = map_chunk();
+  }
+  c->next = h.chunks;
+  c->nlive.store(0u);
+  c->tid = tid;
+  h.chunks = c;
+  h.current = c;
+  h.bump = reinterpret_cast<char*>(c) + CHUNK_HEADER_SIZE;
+}
+
+/**
+ * Release a chunk that no longer contains any allocated blocks. One such
+ * chunk is kept for reuse, with its pages returned to the operating system;
+ * any others are unmapped.
+ */
+static void release_chunk(ThreadHeap& h, Chunk* c) {
+  if (!h.spare) {
+    madvise(c, CHUNK_SIZE, MADV_DONTNEED);
+    h.spare = c;
+  } else {
+    munmap(c, CHUNK_SIZE);
+  }
+  update_usage(-ptrdiff_t(CHUNK_SIZE));
+}
+
+/**
+ * Bump allocate a new block on the current thread.
+ *
+ * @param tid Id of the current thread.
+ * @param n Number of bytes.
+ */
+static void* bump(const int tid, const size_t n) {
+  auto& h = thread_heap(tid);
+  if (!h.current || h.bump + n > reinterpret_cast<char*>(h.current) +
+      CHUNK_SIZE) {
+    new_chunk(h, tid);
+  }
+  auto ptr = h.bump;
+  h.bump += n;
+  return ptr;
+}
+
+/**
+ * Allocate a large block directly from the operating system.
+ */
+static void* allocate_large(const size_t n) {
+  auto m = round_pages(n);
+  auto ptr = map(m);
+  update_usage(m);
+  return ptr;
+}
+
+/**
+ * Deallocate a large block directly to the operating system.
+ */
+static void deallocate_large(void* ptr, const size_t n) {
+  auto m = round_pages(n);
+  munmap(ptr, m);
+  update_usage(-ptrdiff_t(m));
+}
+
+/**
+ * Reallocate a large block directly with the operating system.
+ */
+static void* reallocate_large(void* ptr1, const size_t n1, const size_t n2) {
+  auto m1 = round_pages(n1);
+  auto m2 = round_pages(n2);
+  void* ptr2 = ptr1;
+  if (m1 != m2) {
+    #ifdef MREMAP_MAYMOVE
+    ptr2 = mremap(ptr1, m1, m2, MREMAP_MAYMOVE);
+    libbirch_error_msg_(ptr2 != MAP_FAILED, "out of memory");
+    #else
+    ptr2 = map(m2);
+    std::memcpy(ptr2, ptr1, std::min(n1, n2));
+    munmap(ptr1, m1);
+    #endif
+    update_usage(ptrdiff_t(m2) - ptrdiff_t(m1));
+  }
+  return ptr2;
+}
+
+/**
+ * Make the pools.
+ */
+static libbirch::Pool* make_pools() {
+  return libbirch::make_thread_array<libbirch::Pool>(
+      64*libbirch::get_max_threads());
 }
 
 /**
  * Get the `i`th pool.
  */
 inline libbirch::Pool& pool(const int i) {
-  static libbirch::Pool* pools =
-      new libbirch::Pool[64*libbirch::get_max_threads()];
+  static libbirch::Pool* pools = make_pools();
   return pools[i];
 }
 
+/**
+ * Batch of blocks freed by one thread, but allocated by another, awaiting
+ * return to the pool of the latter. The blocks are linked through their
+ * first 8 bytes, as in Pool.
+ */
+struct RemoteBatch {
+  void* first;
+  void* last;
+  unsigned count;
+};
+
+/**
+ * Number of blocks to accumulate in a RemoteBatch before returning them to
+ * their pool.
+ */
+static const unsigned REMOTE_BATCH_SIZE = 64u;
+
+/**
+ * Get the remote batch for thread `tid`, destined for the `i`th pool.
+ */
+inline RemoteBatch& remote_batch(const int tid, const int i) {
+  /* calloc() is used so that the batches of threads that never free remote
+   * blocks are never touched */
+  static RemoteBatch* batches = static_cast<RemoteBatch*>(std::calloc(
+      64*libbirch::get_max_threads()*libbirch::get_max_threads(),
+      sizeof(RemoteBatch)));
+  return batches[64*libbirch::get_max_threads()*tid + i];
+}
+
+/**
+ * Get the remote batch for the current thread, destined for the `i`th pool.
+ */
+inline RemoteBatch& remote_batch(const int i) {
+  return remote_batch(libbirch::get_thread_num(), i);
+}
+
+/**
+ * Return a remote batch to its pool.
+ */
+inline void flush(RemoteBatch& batch, const int i) {
+  if (batch.count > 0u) {
+    pool(i).give(batch.first, batch.last);
+    batch.first = nullptr;
+    batch.last = nullptr;
+    batch.count = 0u;
+  }
+}
+
+/**
+ * Return all remote batches of thread `tid` to their pools. Must only be
+ * called by that thread, or outside of any parallel region.
+ */
+static void flush_remote_batches(const int tid) {
+  #ifndef DISABLE_MEMORY_POOL
+  for (int i = 0; i < 64*libbirch::get_max_threads(); ++i) {
+    flush(remote_batch(tid, i), i);
+  }
+  #endif
+}
+
+/**
+ * Return all remote batches of the current thread to their pools.
+ */
+static void flush_remote_batches() {
+  flush_remote_batches(libbirch::get_thread_num());
+}
+
+/**
+ * Release the chunks of the current thread that no longer contain any
+ * allocated blocks. This must only be called while no other thread is
+ * allocating or deallocating.
+ */
+static void release_chunks() {
+  #ifndef DISABLE_MEMORY_POOL
+  int tid = libbirch::get_thread_num();
+  auto& h = thread_heap(tid);
+  auto current = h.current;
+  auto empty = [current](void* block) {
+    auto c = chunk(block);
+    return c != current && c->nlive.loadAcquire() == 0u;
+  };
+
+  /* first check if there are any chunks to release at all, as this is
+   * cheap, unlike the removal of their blocks from the pools */
+  bool any = false;
+  for (auto c = h.chunks; c && !any; c = c->next) {
+    any = c != current && c->nlive.loadAcquire() == 0u;
+  }
+  if (any) {
+    for (int i = 0; i < 64; ++i) {
+      pool(64*tid + i).removeIf(empty);
+    }
+    auto prev = &h.chunks;
+    while (*prev) {
+      auto c = *prev;
+      if (c != current && c->nlive.loadAcquire() == 0u) {
+        *prev = c->next;
+        release_chunk(h, c);
+      } else {
+        prev = &c->next;
+      }
+    }
+  }
+  #endif
+}
+
+/**
+ * Number of size classes per doubling of allocation size.
+ */
+static const int CLASSES_PER_DOUBLING = 4;
+
 /**
  * For an allocation size, determine the index of the pool to which it
  * belongs.
@@ -93,22 +551,32 @@ inline libbirch::Pool& pool(const int i) {
  *
  * @return Pool index.
  *
- * Pool sizes are multiples of 8 bytes up to 64 bytes, and powers of two
- * thereafter.
+ * Pool sizes are multiples of 16 bytes up to 64 bytes. Thereafter, each
+ * doubling of size is divided into four equally-spaced classes, as in
+ * jemalloc: 80, 96, 112, 128, 160, 192, 224, 256, 320, etc. This bounds the
+ * internal fragmentation of any allocation at 20%, rather than the 50% of
+ * power-of-two sizes. All sizes are multiples of 16 bytes, so that blocks
+ * are suitably aligned for any fundamental type. For allocations up to
+ * LARGE_SIZE, this gives 48 classes, within the 64 pools of each thread.
  */
 inline int bin(const size_t n) {
   assert(n > 0ull);
   int result = 0;
-  #ifdef HAVE___BUILTIN_CLZLL
-  if (n > 64ull) {
-    /* __builtin_clzll undefined for zero argument */
-    result = 64 - __builtin_clzll((n - 1ull) >> 6ull);
-  }
-  #else
-  while (((n - 1ull) >> (6 + result)) > 0) {
-    ++result;
+  if (n <= 64ull) {
+    result = int((n - 1ull) >> 4ull);
+  } else {
+    /* k such that 2^k < n <= 2^(k + 1) */
+    int k = 0;
+    #ifdef HAVE___BUILTIN_CLZLL
+    k = 63 - __builtin_clzll(n - 1ull);
+    #else
+    while (((n - 1ull) >> (k + 1)) > 0) {
+      ++k;
+    }
+    #endif
+    int j = int((n - 1ull - (1ull << k)) >> (k - 2));
+    result = CLASSES_PER_DOUBLING*(k - 5) + j;
   }
-  #endif
   assert(0 <= result && result <= 63);
   return result;
 }
@@ -117,7 +585,28 @@ inline int bin(const size_t n) {
  * Determine the size for a given bin.
  */
 inline size_t unbin(const int i) {
-  return 64ull << i;
+  if (i < CLASSES_PER_DOUBLING) {
+    return 16ull*(i + 1);
+  } else {
+    int k = i/CLASSES_PER_DOUBLING + 5;
+    int j = i % CLASSES_PER_DOUBLING;
+    return (1ull << k) + (j + 1ull)*(1ull << (k - 2));
+  }
+}
+
+/**
+ * Count an allocation or deallocation in the runtime statistics.
+ *
+ * @param counts The counts, by size class.
+ * @param n Number of bytes.
+ */
+inline void count_block(
+    uint64_t (libbirch::Stats::* counts)[libbirch::Stats::NBINS],
+    const size_t n) {
+  if (libbirch::stats_enabled.loadRelaxed()) {
+    int i = n > LARGE_SIZE ? libbirch::Stats::NBINS - 1 : bin(n);
+    (libbirch::thread_stats().*counts)[i] += 1u;
+  }
 }
 
 libbirch::Label*& libbirch::root() {
@@ -127,16 +616,25 @@ libbirch::Label*& libbirch::root() {
 
 void* libbirch::allocate(const size_t n) {
   assert(n > 0u);
+  count_block(&Stats::nallocs, n);
 
   #ifdef DISABLE_MEMORY_POOL
   return std::malloc(n);
   #else
-  int tid = get_thread_num();
-  int i = bin(n);       // determine which pool
-  auto ptr = pool(64*tid + i).pop();  // attempt to reuse from this pool
-  if (!ptr) {           // otherwise allocate new
-    size_t m = unbin(i);
-    ptr = (heap() += m) - m;
+  void* ptr = nullptr;
+  if (n > LARGE_SIZE) {
+    ptr = allocate_large(n);
+  } else {
+    int tid = get_thread_num();
+    int i = bin(n);       // determine which pool
+    ptr = pool(64*tid + i).pop();  // attempt to reuse from this pool
+    if (ptr) {
+      count_stat(&Stats::npoolhits);
+    } else {              // otherwise allocate new
+      ptr = bump(tid, unbin(i));
+      count_stat(&Stats::nbumps);
+    }
+    chunk(ptr)->nlive.incrementRelaxed();
   }
   assert(ptr);
   return ptr;
@@ -147,12 +645,36 @@ void libbirch::deallocate(void* ptr, const size_t n, const int tid) {
   assert(ptr);
   assert(n > 0u);
   assert(tid < get_max_threads());
+  count_block(&Stats::nfrees, n);
 
   #ifdef DISABLE_MEMORY_POOL
   std::free(ptr);
   #else
-  int i = bin(n);
-  pool(64*tid + i).push(ptr);
+  if (n > LARGE_SIZE) {
+    deallocate_large(ptr, n);
+  } else {
+    /* the owning thread is taken from the chunk, not from tid, as the
+     * latter may be inaccurate for allocations made via Allocator */
+    auto c = chunk(ptr);
+    c->nlive.decrementRelaxed();
+    int i = 64*c->tid + bin(n);
+    if (c->tid == get_thread_num()) {
+      /* local free, return directly to own pool */
+      pool(i).push(ptr);
+    } else {
+      /* remote free, accumulate into a batch to return to the pool of the
+       * allocating thread, in order to amortize the synchronization cost */
+      auto& batch = remote_batch(i);
+      *reinterpret_cast<void**>(ptr) = batch.first;
+      batch.first = ptr;
+      if (!batch.last) {
+        batch.last = ptr;
+      }
+      if (++batch.count >= REMOTE_BATCH_SIZE) {
+        flush(batch, i);
+      }
+    }
+  }
   #endif
 }
 
@@ -164,12 +686,14 @@ void* libbirch::reallocate(void* ptr1, const size_t n1, const int tid1,
   assert(n2 > 0u);
 
   #ifdef DISABLE_MEMORY_POOL
+  count_block(&Stats::nfrees, n1);
+  count_block(&Stats::nallocs, n2);
   return std::realloc(ptr1, n2);
   #else
-  int i1 = bin(n1);
-  int i2 = bin(n2);
   void* ptr2 = ptr1;
-  if (i1 != i2) {
+  if (n1 > LARGE_SIZE && n2 > LARGE_SIZE) {
+    ptr2 = reallocate_large(ptr1, n1, n2);
+  } else if (n1 > LARGE_SIZE || n2 > LARGE_SIZE || bin(n1) != bin(n2)) {
     /* can't continue using current allocation */
     ptr2 = allocate(n2);
     if (ptr1 && ptr2) {
@@ -181,10 +705,118 @@ void* libbirch::reallocate(void* ptr1, const size_t n1, const int tid1,
   #endif
 }
 
+void* libbirch::allocate_aligned(const size_t n) {
+  void* ptr = nullptr;
+  int res = posix_memalign(&ptr, 64ull, n);
+  libbirch_error_msg_(res == 0, "out of memory allocating " << n <<
+      " bytes aligned to cache lines");
+  return ptr;
+}
+
+size_t libbirch::bin_size(const int i) {
+  return unbin(i);
+}
+
+size_t libbirch::heap_size() {
+  auto& u = usage();
+  u.lock.set();
+  auto result = u.current;
+  u.lock.unset();
+  return result;
+}
+
+size_t libbirch::heap_peak() {
+  auto& u = usage();
+  u.lock.set();
+  auto result = u.peak;
+  u.lock.unset();
+  return result;
+}
+
+/**
+ * Release, at exit, what would otherwise be released only by a cycle
+ * collection: merge the objects of the merge queues, which destroys those
+ * with no remaining references, and release the possible roots that are no
+ * longer possible roots, such as those destroyed. Without this, the objects
+ * of a thread that does not allocate again after other threads release them
+ * are never destroyed, and the memory of destroyed objects in the buffer of
+ * possible roots is never freed.
+ *
+ * The OpenMP runtime may already have shut down at exit, so this does the
+ * work of all threads on the calling thread, which is safe as no other
+ * thread is running.
+ */
+static void release_at_exit() {
+  using namespace libbirch;
+  if (!in_parallel()) {
+    int nthreads = get_max_threads();
+
+    /* destroying an object may queue others for a merge, so repeat until
+     * all queues are empty */
+    bool pending = true;
+    while (pending) {
+      pending = false;
+      for (int tid = 0; tid < nthreads; ++tid) {
+        if (get_merge_queue(tid).pending.loadRelaxed()) {
+          merge_queue(tid);
+          pending = true;
+        }
+      }
+    }
+    for (int tid = 0; tid < nthreads; ++tid) {
+      auto& possible_roots = get_possible_roots(tid);
+      auto last = std::remove_if(possible_roots.begin(), possible_roots.end(),
+          [](Any* o) {
+            if (!o->isPossibleRoot()) {
+              o->decMemo();
+              return true;
+            } else {
+              return false;
+            }
+          });
+      possible_roots.erase(last, possible_roots.end());
+    }
+    for (int tid = 0; tid < nthreads; ++tid) {
+      flush_remote_batches(tid);
+    }
+  }
+}
+
+/**
+ * Register release_at_exit() to run at exit.
+ *
+ * @return Zero on success.
+ */
+static int make_release_at_exit() {
+  /* release_at_exit() uses the lists of possible roots and unreachable
+   * objects, so these must be destroyed after it runs; functions registered
+   * with atexit run in reverse order of their registration, interleaved
+   * with the destructors of static objects, so construct these lists
+   * first */
+  get_thread_possible_roots();
+  get_thread_unreachable();
+  return std::atexit(release_at_exit);
+}
+
+/**
+ * Register release_at_exit() to run at exit, if not already registered.
+ */
+static void register_release_at_exit() {
+  static int res = make_release_at_exit();
+  libbirch_error_msg_(res == 0, "could not register release at exit");
+}
+
 void libbirch::register_possible_root(Any* o) {
   assert(o);
+  register_release_at_exit();
   o->incMemo();
-  get_thread_possible_roots().emplace_back(o);
+  auto& possible_roots = get_thread_possible_roots();
+  possible_roots.emplace_back(o);
+  count_stat(&Stats::nroots);
+  auto nroots = collect_nroots.loadRelaxed();
+  if (nroots > 0u && possible_roots.size() >= nroots) {
+    collect_due.storeRelaxed(true);
+  }
 }
 
 void libbirch::register_unreachable(Any* o) {
@@ -196,53 +828,220 @@ void libbirch::register_unreachable(Any* o) {
   get_thread_unreachable().emplace_back(o);
 }
 
-void libbirch::collect() {
+void libbirch::register_merge(Any* o, const int tid) {
+  assert(o);
+  register_release_at_exit();
+  o->incMemo();
+  auto& queue = get_merge_queue(tid);
+  queue.lock.set();
+  queue.objects.emplace_back(o);
+  queue.pending.storeRelaxed(true);
+  auto nqueued = queue.objects.size();
+  queue.lock.unset();
+
+  /* objects queued for a thread that does not allocate are merged only by
+   * a collection, so count them toward the threshold too */
+  auto nroots = collect_nroots.loadRelaxed();
+  if (nroots > 0u && nqueued >= nroots) {
+    collect_due.storeRelaxed(true);
+  }
+}
+
+void libbirch::merge_registered() {
+  merge_queue();
+}
+
+/**
+ * Possible roots gathered from all threads for a cycle collection, which
+ * threads then take in chunks, so that the work is shared even if one
+ * thread registered most of them.
+ */
+struct GatheredRoots {
+  /**
+   * Lock.
+   */
+  libbirch::Lock lock;
+
+  /**
+   * Objects.
+   */
+  object_list objects;
+};
+
+/**
+ * Get the gathered possible roots.
+ */
+static GatheredRoots& get_gathered_roots() {
+  static GatheredRoots roots;
+  return roots;
+}
+
+/**
+ * Get the timings of the last cycle collection, one per thread.
+ */
+static std::vector<libbirch::CollectTimings,
+    libbirch::Allocator<libbirch::CollectTimings>>& get_timings() {
+  static std::vector<libbirch::CollectTimings,
+      libbirch::Allocator<libbirch::CollectTimings>> timings(
+      libbirch::get_max_threads());
+  return timings;
+}
+
+/**
+ * Number of possible roots that a thread takes at once in each phase of a
+ * cycle collection.
+ */
+static const int COLLECT_CHUNK = 64;
+
+/**
+ * Run the cycle collector.
+ *
+ * @param budget Largest number of possible roots that each thread
+ * contributes, or zero for all.
+ */
+static void collect(const size_t budget) {
+  using namespace libbirch;
+  using clock = std::chrono::steady_clock;
+  collect_due.storeRelaxed(false);
+  auto ncollected = stats_enabled.loadRelaxed() ? stats().ncollected : 0u;
+
   #pragma omp parallel num_threads(get_max_threads())
   {
-    /* mark */
+    auto& timings = get_timings()[get_thread_num()];
+    auto start = clock::now();
+    auto lap = [&]() {
+      auto now = clock::now();
+      std::chrono::duration<double> elapsed = now - start;
+      start = now;
+      return elapsed.count();
+    };
+
+    /* merge shared counts of objects registered by other threads, which may
+     * destroy some objects, and register others as possible roots */
+    merge_queue();
+
+    /* gather possible roots, taking the oldest of each thread first, so
+     * that none is left registered indefinitely */
     auto& possible_roots = get_thread_possible_roots();
-    for (auto& o : possible_roots) {
-      if (o) {
-        if (o->isPossibleRoot()) {
-          o->mark();
-        } else {
-          o->decMemo();
-          o = nullptr;
-        }
+    auto first = possible_roots.begin();
+    auto last = possible_roots.end();
+    if (budget > 0u && size_t(last - first) > budget) {
+      last = first + budget;
+    }
+    auto& roots = get_gathered_roots();
+    roots.lock.set();
+    roots.objects.insert(roots.objects.end(), first, last);
+    roots.lock.unset();
+    possible_roots.erase(first, last);
+    timings.merge = lap();
+    #pragma omp barrier
+    start = clock::now();
+
+    /* mark */
+    int nroots = int(roots.objects.size());
+    timings.nroots = 0u;
+    #pragma omp for schedule(dynamic, COLLECT_CHUNK) nowait
+    for (int i = 0; i < nroots; ++i) {
+      auto& o = roots.objects[i];
+      if (o->isPossibleRoot()) {
+        o->mark();
+      } else {
+        o->decMemo();
+        o = nullptr;
       }
+      ++timings.nroots;
     }
+    timings.mark = lap();
     #pragma omp barrier
+    start = clock::now();
 
     /* scan */
-    for (auto& o : possible_roots) {
+    #pragma omp for schedule(dynamic, COLLECT_CHUNK) nowait
+    for (int i = 0; i < nroots; ++i) {
+      auto& o = roots.objects[i];
       if (o) {
         o->scan();
       }
     }
+    timings.scan = lap();
     #pragma omp barrier
+    start = clock::now();
 
     /* collect */
-    for (auto& o : possible_roots) {
+    #pragma omp for schedule(dynamic, COLLECT_CHUNK) nowait
+    for (int i = 0; i < nroots; ++i) {
+      auto& o = roots.objects[i];
       if (o) {
         o->collect();
         o->decMemo();
         o = nullptr;
       }
     }
-    possible_roots.clear();
+    timings.collect = lap();
     #pragma omp barrier
+    start = clock::now();
 
-    /* destroy the objects indicated during collect */
+    /* destroy the objects indicated during collect; these are shared
+     * between threads by the chunks taken during collect */
+    #pragma omp master
+    roots.objects.clear();
     auto& unreachable = get_thread_unreachable();
+    count_stat(&Stats::ncollected, unreachable.size());
     for (auto& o : unreachable) {
       o->destroy();
       o->decMemo();  // removes last memo count
     }
-
     unreachable.clear();
+
+    /* return any blocks freed on behalf of other threads */
+    flush_remote_batches();
+    timings.destroy = lap();
+    #pragma omp barrier
+    start = clock::now();
+
+    /* return any chunks that are now free to the operating system */
+    release_chunks();
+    timings.release = lap();
+  }
+
+  auto& u = usage();
+  u.lock.set();
+  u.collected = u.current;
+  u.lock.unset();
+
+  if (stats_enabled.loadRelaxed()) {
+    auto& s = thread_stats();
+    ++s.ncollects;
+    s.maxcollected = std::max(s.maxcollected, stats().ncollected -
+        ncollected);
+  }
+}
+
+void libbirch::collect() {
+  ::collect(0u);
+}
+
+void libbirch::collect_if_due() {
+  if (collect_due.loadRelaxed() && !in_parallel()) {
+    ::collect(collect_budget.loadRelaxed());
   }
 }
 
+std::vector<libbirch::CollectTimings> libbirch::collect_timings() {
+  auto& timings = get_timings();
+  return std::vector<CollectTimings>(timings.begin(), timings.end());
+}
+
+void libbirch::set_collect_threshold(const size_t nroots,
+    const size_t nbytes) {
+  collect_nroots.store(nroots);
+  collect_nbytes.store(nbytes);
+}
+
+void libbirch::set_collect_budget(const size_t nroots) {
+  collect_budget.store(nroots);
+}
+
 void libbirch::trim(Any* o) {
   auto& possible_roots = get_thread_possible_roots();
   while (!possible_roots.empty()) {
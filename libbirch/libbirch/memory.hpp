@@ -26,6 +26,12 @@ extern ExitBarrierLock finish_lock;
  */
 extern ExitBarrierLock freeze_lock;
 
+/**
+ * Is an automatic cycle collection due? Set when a threshold given to
+ * set_collect_threshold() is reached, and checked by collect_if_due().
+ */
+extern Atomic<bool> collect_due;
+
 /**
  * Get the root label.
  */
@@ -63,6 +69,54 @@ void deallocate(void* ptr, const size_t n, const int tid);
 void* reallocate(void* ptr1, const size_t n1, const int tid1,
     const size_t n2);
 
+/**
+ * Allocate memory aligned to cache lines, directly from the operating
+ * system rather than from the heap. Aborts if the memory cannot be
+ * allocated.
+ *
+ * @param n Number of bytes.
+ *
+ * @return Pointer to the allocated memory, which is never freed.
+ */
+void* allocate_aligned(const size_t n);
+
+/**
+ * Make an array of objects for the use of individual threads, such as one
+ * for each thread, where the element type is aligned to cache lines so that
+ * threads do not share them. The array is never freed.
+ *
+ * @tparam T Element type.
+ *
+ * @param n Number of elements.
+ *
+ * @return The array, with each element value-initialized.
+ */
+template<class T>
+T* make_thread_array(const size_t n) {
+  auto ptr = static_cast<T*>(allocate_aligned(n*sizeof(T)));
+  for (size_t i = 0; i < n; ++i) {
+    new (ptr + i) T();
+  }
+  return ptr;
+}
+
+/**
+ * Size of the blocks of the `i`th allocation size class, each of which is
+ * served by one pool of each thread.
+ */
+size_t bin_size(const int i);
+
+/**
+ * Number of bytes currently obtained from the operating system for the heap.
+ */
+size_t heap_size();
+
+/**
+ * Maximum number of bytes obtained from the operating system for the heap at
+ * any one time (the high-water mark).
+ */
+size_t heap_peak();
+
 /**
  * Register an object with the cycle collector as the possible root of a
  * cycle. This corresponds to the `PossibleRoot()` operation in @ref Bacon2001
@@ -75,11 +129,120 @@ void register_possible_root(Any* o);
  */
 void register_unreachable(Any* o);
 
+/**
+ * Register an object for the owning thread to merge the local part of its
+ * shared count into the shared part. This is used when a thread other than
+ * the owning thread reduces the shared part to zero or below. The owning
+ * thread merges when it next allocates an object (see merge_registered()),
+ * at the start of the next cycle collection, or at exit, whichever comes
+ * first.
+ *
+ * @param o The object.
+ * @param tid Id of the owning thread.
+ */
+void register_merge(Any* o, const int tid);
+
+/**
+ * Merge the shared counts of objects of the current thread that other
+ * threads have registered with register_merge(), destroying those with no
+ * remaining references. This is called when the thread allocates an
+ * object, and costs only a check when there are none.
+ */
+void merge_registered();
+
 /**
  * Run the cycle collector.
  */
 void collect();
 
+/**
+ * Timings of the phases of a cycle collection on one thread. Each is the
+ * time, in seconds, that the thread spent on its share of the phase, not
+ * counting the time that it then waited for other threads to finish theirs,
+ * so that any imbalance between threads is visible.
+ *
+ * @ingroup libbirch
+ */
+struct CollectTimings {
+  /**
+   * Merging shared counts and gathering possible roots.
+   */
+  double merge;
+
+  /**
+   * Marking from possible roots.
+   */
+  double mark;
+
+  /**
+   * Scanning from possible roots.
+   */
+  double scan;
+
+  /**
+   * Collecting from possible roots.
+   */
+  double collect;
+
+  /**
+   * Destroying unreachable objects.
+   */
+  double destroy;
+
+  /**
+   * Returning memory to the operating system.
+   */
+  double release;
+
+  /**
+   * Number of possible roots that the thread marked from.
+   */
+  size_t nroots;
+};
+
+/**
+ * Get the timings of the phases of the last cycle collection, one per
+ * thread.
+ */
+std::vector<CollectTimings> collect_timings();
+
+/**
+ * Run the cycle collector if an automatic collection is due, and the
+ * calling thread is not within a parallel region, including that of a
+ * collection. The caller must be at a safe point for the collector, where
+ * no object is under construction; the standard library calls this at the
+ * start of each step of its particle filters, and between the steps of its
+ * sample program. The collection is incremental if a budget has been set
+ * with set_collect_budget().
+ */
+void collect_if_due();
+
+/**
+ * Set the thresholds for automatic cycle collection. A collection becomes
+ * due when either threshold is reached, and runs at the next safe point
+ * (@see collect_if_due()). The collector still runs whenever collect() is
+ * called.
+ *
+ * @param nroots Number of possible roots registered by any one thread, or
+ * of objects queued for any one thread to merge (@see register_merge()), or
+ * zero for no such threshold.
+ * @param nbytes Number of bytes by which the heap has grown since the end
+ * of the last collection, or zero for no such threshold.
+ */
+void set_collect_threshold(const size_t nroots, const size_t nbytes);
+
+/**
+ * Set the budget for automatic cycle collection.
+ *
+ * @param nroots Largest number of possible roots that each thread
+ * processes in an automatic collection, or zero for all. Those not
+ * processed remain registered for the next collection.
+ *
+ * A budget bounds the pause time of each automatic collection, at the cost
+ * of more frequent collections. It does not apply to collect().
+ */
+void set_collect_budget(const size_t nroots);
+
 /**
  * Performs some maintenance operations on the current thread's set of
  * registered possible roots.
@@ -0,0 +1,176 @@
+/**
+ * @file
+ */
+#include "libbirch/profile.hpp"
+
+#include "libbirch/memory.hpp"
+#include "libbirch/thread.hpp"
+
+/**
+ * Counts of live objects of a class.
+ */
+struct ClassCounts {
+  int64_t nobjects = 0;
+  int64_t nbytes = 0;
+};
+
+/**
+ * Heap profile of a thread, on its own cache lines. Objects may be
+ * destroyed by a thread other than that which created them, so the counts
+ * of one thread may be negative; only their sums are meaningful. Classes
+ * are keyed by the address of their name, which is constant for each class.
+ */
+struct alignas(64) ThreadProfile {
+  std::unordered_map<const char*,ClassCounts> classes;
+};
+
+/**
+ * Snapshot of the heap profile.
+ */
+struct Snapshot {
+  int64_t step;
+  std::vector<libbirch::ClassProfile> classes;
+};
+
+/**
+ * Make the heap profiles of all threads.
+ */
+static ThreadProfile* make_thread_profiles() {
+  return libbirch::make_thread_array<ThreadProfile>(
+      libbirch::get_max_threads());
+}
+
+/**
+ * Get the heap profile of the `i`th thread.
+ */
+static ThreadProfile& thread_profile(const int i) {
+  static ThreadProfile* profiles = make_thread_profiles();
+  return profiles[i];
+}
+
+/**
+ * Get the snapshots of the heap profile.
+ */
+static std::vector<Snapshot>& snapshots() {
+  static std::vector<Snapshot> snapshots;
+  return snapshots;
+}
+
+/**
+ * Write the classes of a heap profile as a JSON array.
+ */
+static void write_classes(std::ostream& out,
+    const std::vector<libbirch::ClassProfile>& classes,
+    const std::string& indent) {
+  out << '[';
+  for (size_t i = 0; i < classes.size(); ++i) {
+    auto& c = classes[i];
+    out << (i == 0 ? "\n" : ",\n");
+    out << indent << "  {\"name\": \"" << c.name << "\", \"objects\": " <<
+        c.nobjects << ", \"bytes\": " << c.nbytes << '}';
+  }
+  if (!classes.empty()) {
+    out << '\n' << indent;
+  }
+  out << ']';
+}
+
+libbirch::Atomic<bool> libbirch::heap_profile_enabled(false);
+
+void libbirch::profile_new(const char* name, const size_t size) {
+  auto& c = thread_profile(get_thread_num()).classes[name];
+  ++c.nobjects;
+  c.nbytes += size;
+}
+
+void libbirch::profile_delete(const char* name, const size_t size) {
+  auto& c = thread_profile(get_thread_num()).classes[name];
+  --c.nobjects;
+  c.nbytes -= size;
+}
+
+void libbirch::set_heap_profile(const bool enable) {
+  heap_profile_enabled.store(enable);
+}
+
+std::vector<libbirch::ClassProfile> libbirch::heap_profile() {
+  /* sum over threads; the same class may have a different address for its
+   * name in different shared libraries, so sum by name */
+  std::unordered_map<std::string,ClassCounts> sums;
+  for (int i = 0; i < get_max_threads(); ++i) {
+    for (auto& entry : thread_profile(i).classes) {
+      auto& c = sums[entry.first];
+      c.nobjects += entry.second.nobjects;
+      c.nbytes += entry.second.nbytes;
+    }
+  }
+
+  std::vector<ClassProfile> result;
+  for (auto& entry : sums) {
+    if (entry.second.nobjects != 0) {
+      result.push_back(ClassProfile{entry.first, entry.second.nobjects,
+          entry.second.nbytes});
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const ClassProfile& a,
+      const ClassProfile& b) {
+    return a.nbytes > b.nbytes || (a.nbytes == b.nbytes && a.name < b.name);
+  });
+  return result;
+}
+
+void libbirch::snapshot_heap_profile(const int64_t step) {
+  snapshots().push_back(Snapshot{step, heap_profile()});
+}
+
+void libbirch::reset_heap_profile() {
+  for (int i = 0; i < get_max_threads(); ++i) {
+    thread_profile(i).classes.clear();
+  }
+  snapshots().clear();
+}
+
+void libbirch::write_heap_profile_json(std::ostream& out) {
+  out << "{\n";
+  out << "  \"classes\": ";
+  write_classes(out, heap_profile(), "  ");
+  out << ",\n";
+  out << "  \"snapshots\": [";
+  auto& s = snapshots();
+  for (size_t i = 0; i < s.size(); ++i) {
+    out << (i == 0 ? "\n" : ",\n");
+    out << "    {\"step\": " << s[i].step << ", \"classes\": ";
+    write_classes(out, s[i].classes, "    ");
+    out << '}';
+  }
+  out << (s.empty() ? "]\n" : "\n  ]\n");
+  out << "}\n";
+}
+
+void libbirch::write_heap_profile_table(std::ostream& out) {
+  auto classes = heap_profile();
+
+  /* largest number of bytes of each class in any snapshot, or now */
+  std::unordered_map<std::string,int64_t> peaks;
+  for (auto& snapshot : snapshots()) {
+    for (auto& c : snapshot.classes) {
+      auto& peak = peaks[c.name];
+      peak = std::max(peak, c.nbytes);
+    }
+  }
+  size_t width = 5;
+  for (auto& c : classes) {
+    auto& peak = peaks[c.name];
+    peak = std::max(peak, c.nbytes);
+    width = std::max(width, c.name.length());
+  }
+
+  out << std::left << std::setw(width) << "class" << std::right <<
+      std::setw(14) << "objects" << std::setw(16) << "bytes" <<
+      std::setw(16) << "peak bytes" << '\n';
+  for (auto& c : classes) {
+    out << std::left << std::setw(width) << c.name << std::right <<
+        std::setw(14) << c.nobjects << std::setw(16) << c.nbytes <<
+        std::setw(16) << peaks[c.name] << '\n';
+  }
+}
@@ -0,0 +1,109 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "libbirch/external.hpp"
+#include "libbirch/Atomic.hpp"
+
+namespace libbirch {
+/**
+ * Live objects of one class in the heap profile.
+ *
+ * @ingroup libbirch
+ */
+struct ClassProfile {
+  /**
+   * Name of the class.
+   */
+  std::string name;
+
+  /**
+   * Number of live objects.
+   */
+  int64_t nobjects;
+
+  /**
+   * Number of bytes of live objects.
+   */
+  int64_t nbytes;
+};
+
+/**
+ * Is the heap profile enabled? See set_heap_profile().
+ */
+extern Atomic<bool> heap_profile_enabled;
+
+/**
+ * Count a new object in the heap profile of the current thread.
+ *
+ * @param name Name of the class of the object.
+ * @param size Size of the object.
+ */
+void profile_new(const char* name, const size_t size);
+
+/**
+ * Count a destroyed object in the heap profile of the current thread.
+ *
+ * @param name Name of the class of the object.
+ * @param size Size of the object.
+ */
+void profile_delete(const char* name, const size_t size);
+
+/**
+ * Enable or disable the heap profile, which counts the live objects and
+ * bytes of each class. It is disabled by default. Only objects created
+ * while it is enabled are counted, so that it is best enabled at the start
+ * of the program.
+ *
+ * @ingroup libbirch
+ */
+void set_heap_profile(const bool enable);
+
+/**
+ * Get the heap profile, summed over all threads, in decreasing order of
+ * bytes.
+ *
+ * @ingroup libbirch
+ */
+std::vector<ClassProfile> heap_profile();
+
+/**
+ * Record a snapshot of the heap profile, such as at the end of each step of
+ * a particle filter. This should not be called concurrently with the
+ * creation or destruction of objects.
+ *
+ * @ingroup libbirch
+ *
+ * @param step Step number, by which to identify the snapshot.
+ */
+void snapshot_heap_profile(const int64_t step);
+
+/**
+ * Reset the heap profile, and discard its snapshots.
+ *
+ * @ingroup libbirch
+ */
+void reset_heap_profile();
+
+/**
+ * Write the heap profile as JSON, with its snapshots.
+ *
+ * @ingroup libbirch
+ *
+ * @param out The output stream.
+ */
+void write_heap_profile_json(std::ostream& out);
+
+/**
+ * Write the heap profile as a flat table, in decreasing order of bytes.
+ * Along with the live objects and bytes of each class, this gives the
+ * largest number of bytes of the class in any snapshot.
+ *
+ * @ingroup libbirch
+ *
+ * @param out The output stream.
+ */
+void write_heap_profile_table(std::ostream& out);
+
+}
@@ -0,0 +1,138 @@
+/**
+ * @file
+ */
+#include "libbirch/stats.hpp"
+
+#include "libbirch/memory.hpp"
+
+/**
+ * Statistics of a thread, on their own cache lines.
+ */
+struct alignas(64) ThreadStats : public libbirch::Stats {
+  //
+};
+
+/**
+ * Make the statistics of all threads.
+ */
+static ThreadStats* make_thread_stats() {
+  /* value initialization zeros the counts */
+  return libbirch::make_thread_array<ThreadStats>(libbirch::get_max_threads());
+}
+
+/**
+ * Get the statistics of the `i`th thread.
+ */
+static ThreadStats& thread_stats(const int i) {
+  static ThreadStats* stats = make_thread_stats();
+  return stats[i];
+}
+
+libbirch::Atomic<bool> libbirch::stats_enabled(false);
+
+libbirch::Stats& libbirch::thread_stats() {
+  return ::thread_stats(get_thread_num());
+}
+
+void libbirch::set_stats(const bool enable) {
+  stats_enabled.store(enable);
+}
+
+libbirch::Stats libbirch::stats() {
+  Stats result;
+  std::memset(&result, 0, sizeof(result));
+  for (int i = 0; i < get_max_threads(); ++i) {
+    auto& s = ::thread_stats(i);
+    for (int j = 0; j < Stats::NBINS; ++j) {
+      result.nallocs[j] += s.nallocs[j];
+      result.nfrees[j] += s.nfrees[j];
+    }
+    result.npoolhits += s.npoolhits;
+    result.nbumps += s.nbumps;
+    result.ncopies += s.ncopies;
+    result.nrecycles += s.nrecycles;
+    result.nhits += s.nhits;
+    result.nputs += s.nputs;
+    result.nrehashes += s.nrehashes;
+    result.nchains += s.nchains;
+    result.nlookups += s.nlookups;
+    result.nlinks += s.nlinks;
+    result.nprobes += s.nprobes;
+    result.ncompressions += s.ncompressions;
+    result.nclones += s.nclones;
+    result.nfinished += s.nfinished;
+    result.nfrozen += s.nfrozen;
+    result.nroots += s.nroots;
+    result.ncollects += s.ncollects;
+    result.ncollected += s.ncollected;
+    result.maxcollected = std::max(result.maxcollected, s.maxcollected);
+  }
+  return result;
+}
+
+void libbirch::reset_stats() {
+  for (int i = 0; i < get_max_threads(); ++i) {
+    Stats& s = ::thread_stats(i);
+    std::memset(&s, 0, sizeof(Stats));
+  }
+}
+
+void libbirch::write_stats(std::ostream& out) {
+  auto s = stats();
+
+  out << "{\n";
+  out << "  \"heap\": {\n";
+  out << "    \"size\": " << heap_size() << ",\n";
+  out << "    \"peak\": " << heap_peak() << ",\n";
+  out << "    \"pool_hits\": " << s.npoolhits << ",\n";
+  out << "    \"bumps\": " << s.nbumps << ",\n";
+  out << "    \"bins\": [";
+  bool first = true;
+  for (int i = 0; i < Stats::NBINS - 1; ++i) {
+    if (s.nallocs[i] > 0u || s.nfrees[i] > 0u) {
+      out << (first ? "\n" : ",\n");
+      out << "      {\"size\": " << bin_size(i) << ", \"allocs\": " <<
+          s.nallocs[i] << ", \"frees\": " << s.nfrees[i] << '}';
+      first = false;
+    }
+  }
+  out << (first ? "],\n" : "\n    ],\n");
+  out << "    \"large\": {\"allocs\": " << s.nallocs[Stats::NBINS - 1] <<
+      ", \"frees\": " << s.nfrees[Stats::NBINS - 1] << "}\n";
+  out << "  },\n";
+  out << "  \"label\": {\n";
+  out << "    \"copies\": " << s.ncopies << ",\n";
+  out << "    \"recycles\": " << s.nrecycles << ",\n";
+  out << "    \"hits\": " << s.nhits << "\n";
+  out << "  },\n";
+  out << "  \"memo\": {\n";
+  out << "    \"puts\": " << s.nputs << ",\n";
+  out << "    \"rehashes\": " << s.nrehashes << ",\n";
+  out << "    \"compressions\": " << s.ncompressions << ",\n";
+  out << "    \"chain_length\": " << s.chainLength() << ",\n";
+  out << "    \"probe_length\": " << s.probeLength() << "\n";
+  out << "  },\n";
+  out << "  \"clone\": {\n";
+  out << "    \"clones\": " << s.nclones << ",\n";
+  out << "    \"finished\": " << s.nfinished << ",\n";
+  out << "    \"frozen\": " << s.nfrozen << "\n";
+  out << "  },\n";
+  out << "  \"collect\": {\n";
+  out << "    \"possible_roots\": " << s.nroots << ",\n";
+  out << "    \"collects\": " << s.ncollects << ",\n";
+  out << "    \"collected\": " << s.ncollected << ",\n";
+  out << "    \"max_collected\": " << s.maxcollected << ",\n";
+  out << "    \"last\": [";
+  auto timings = collect_timings();
+  for (size_t i = 0; i < timings.size(); ++i) {
+    auto& t = timings[i];
+    out << (i == 0 ? "\n" : ",\n");
+    out << "      {\"roots\": " << t.nroots << ", \"merge\": " << t.merge <<
+        ", \"mark\": " << t.mark << ", \"scan\": " << t.scan <<
+        ", \"collect\": " << t.collect << ", \"destroy\": " << t.destroy <<
+        ", \"release\": " << t.release << '}';
+  }
+  out << (timings.empty() ? "]\n" : "\n    ]\n");
+  out << "  }\n";
+  out << "}\n";
+}
@@ -0,0 +1,207 @@
+/**
+ * @file
+ */
+#pragma once
+
+#include "libbirch/external.hpp"
+#include "libbirch/thread.hpp"
+#include "libbirch/Atomic.hpp"
+
+namespace libbirch {
+/**
+ * Runtime statistics, as counts of operations. Each thread counts its own,
+ * and stats() sums them.
+ *
+ * @ingroup libbirch
+ */
+struct Stats {
+  /**
+   * Number of allocation size classes, each served by one pool of each
+   * thread (see bin_size()), and a last for allocations too large for
+   * pools.
+   */
+  static const int NBINS = 65;
+
+  /**
+   * Number of allocations, by size class.
+   */
+  uint64_t nallocs[NBINS];
+
+  /**
+   * Number of deallocations, by size class.
+   */
+  uint64_t nfrees[NBINS];
+
+  /**
+   * Number of allocations served by reusing a block from a pool.
+   */
+  uint64_t npoolhits;
+
+  /**
+   * Number of allocations served by bumping into a new block of a chunk.
+   */
+  uint64_t nbumps;
+
+  /**
+   * Number of objects copied on write through a label (Label::mapGet()).
+   */
+  uint64_t ncopies;
+
+  /**
+   * Number of objects recycled on write through a label, as the final
+   * reference to them was being updated (Label::mapGet()).
+   */
+  uint64_t nrecycles;
+
+  /**
+   * Number of writes through a label that found an existing copy in its
+   * memo (Label::mapGet()).
+   */
+  uint64_t nhits;
+
+  /**
+   * Number of entries put in memos.
+   */
+  uint64_t nputs;
+
+  /**
+   * Number of rehashes of memos.
+   */
+  uint64_t nrehashes;
+
+  /**
+   * Number of lookups through labels, each of which follows a chain of memo
+   * entries.
+   */
+  uint64_t nchains;
+
+  /**
+   * Number of keys looked up in memos.
+   */
+  uint64_t nlookups;
+
+  /**
+   * Number of memo entries followed.
+   */
+  uint64_t nlinks;
+
+  /**
+   * Number of memo trie nodes visited.
+   */
+  uint64_t nprobes;
+
+  /**
+   * Number of chains shortened by Memo::compress().
+   */
+  uint64_t ncompressions;
+
+  /**
+   * Number of clones, lazy or eager.
+   */
+  uint64_t nclones;
+
+  /**
+   * Number of objects visited by finish operations.
+   */
+  uint64_t nfinished;
+
+  /**
+   * Number of objects visited by freeze operations.
+   */
+  uint64_t nfrozen;
+
+  /**
+   * Number of objects registered as possible roots for cycle collection.
+   */
+  uint64_t nroots;
+
+  /**
+   * Number of cycle collections.
+   */
+  uint64_t ncollects;
+
+  /**
+   * Number of objects found unreachable by cycle collections.
+   */
+  uint64_t ncollected;
+
+  /**
+   * Largest number of objects found unreachable by one cycle collection.
+   */
+  uint64_t maxcollected;
+
+  /**
+   * Average number of memo entries followed per lookup through a label.
+   */
+  double chainLength() const {
+    return nchains ? double(nlinks)/nchains : 0.0;
+  }
+
+  /**
+   * Average number of memo trie nodes visited per key looked up.
+   */
+  double probeLength() const {
+    return nlookups ? double(nprobes)/nlookups : 0.0;
+  }
+};
+
+/**
+ * Is the collection of runtime statistics enabled? See set_stats().
+ */
+extern Atomic<bool> stats_enabled;
+
+/**
+ * Get the statistics of the current thread.
+ */
+Stats& thread_stats();
+
+/**
+ * Increment a counter of the current thread, if the collection of runtime
+ * statistics is enabled.
+ *
+ * @param counter The counter.
+ * @param n The increment.
+ */
+inline void count_stat(uint64_t Stats::* counter, const uint64_t n = 1u) {
+  if (stats_enabled.loadRelaxed()) {
+    thread_stats().*counter += n;
+  }
+}
+
+/**
+ * Enable or disable the collection of runtime statistics. They are disabled
+ * by default, in which case the counting of each operation costs only a
+ * check of this setting.
+ *
+ * @ingroup libbirch
+ */
+void set_stats(const bool enable);
+
+/**
+ * Get the runtime statistics, summed over all threads.
+ *
+ * @ingroup libbirch
+ */
+Stats stats();
+
+/**
+ * Reset the runtime statistics to zero. This should not be called
+ * concurrently with the operations counted.
+ *
+ * @ingroup libbirch
+ */
+void reset_stats();
+
+/**
+ * Write the runtime statistics, summed over all threads, as JSON. Along with
+ * the counts of Stats, this includes the heap size, the average lengths of
+ * memo chains and probes, and the timings of the last cycle collection (see
+ * CollectTimings).
+ *
+ * @ingroup libbirch
+ *
+ * @param out The output stream.
+ */
+void write_stats(std::ostream& out);
+
+}
@@ -33,4 +33,18 @@ inline int get_thread_num() {
 #endif
 }
 
+/**
+ * Is the current thread within a parallel region? This includes a region
+ * with a team of one thread, and that of a cycle collection.
+ *
+ * @ingroup libbirch
+ */
+inline bool in_parallel() {
+#ifdef _OPENMP
+  return omp_get_level() > 0;
+#else
+  return false;
+#endif
+}
+
 }
@@ -102,7 +102,13 @@ struct is_acyclic<void,N> {
 /**
  * Is `T` an acyclic class?
  *
- * An acyclic class is a class with all members of acyclic type.
+ * An acyclic class is a class with all members of acyclic type. Every object
+ * also has a label, which is not acyclic, so the default never holds for
+ * classes derived from Any; the driver instead proves acyclic those classes
+ * with all members, other than the label, of acyclic type, and specializes
+ * this for them. Objects of such classes can still be part of a cycle
+ * through their label, which is accounted for when they are released (see
+ * Any::decSharedAcyclicClass()).
  *
  * @seealso is_acyclic
  */
@@ -0,0 +1,123 @@
+/**
+ * @file
+ *
+ * Test of the destruction of objects released by threads other than their
+ * owning thread, without a cycle collection. Such objects are registered for
+ * their owning thread to merge their shared counts, which it should do when
+ * it next allocates an object, so that the number of live objects remains
+ * bounded over rounds rather than growing with each.
+ *
+ * In each round, each thread allocates objects, and the next thread
+ * releases them. There are never more than two rounds of objects live: those
+ * of the current round, and those of the previous round not yet merged.
+ *
+ * Finally, one thread allocates objects that another releases, and does not
+ * allocate again. The objects queued for it to merge should count toward the
+ * threshold for automatic cycle collection, so that collect_if_due() merges
+ * and destroys them.
+ *
+ * Usage:
+ *
+ *     test/merge [nobjects] [nrounds]
+ *
+ * Exits with a nonzero status on failure, or 77 (skipped) if only one
+ * thread is available.
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Minimal class for the test, which counts its live objects.
+ */
+class Object : public libbirch::Any {
+public:
+  using class_type_ = Object;
+  using this_type_ = Object;
+  using super_type_ = libbirch::Any;
+
+  Object() {
+    ++nlive;
+  }
+
+  virtual ~Object() {
+    --nlive;
+  }
+
+  /**
+   * Number of live objects.
+   */
+  static std::atomic<int64_t> nlive;
+
+  LIBBIRCH_CLASS(Object, libbirch::Any)
+  LIBBIRCH_MEMBERS()
+};
+
+std::atomic<int64_t> Object::nlive(0);
+}
+}
+
+using Pointer = libbirch::Shared<birch::type::Object>;
+
+int main(int argc, char** argv) {
+  int nobjects = argc > 1 ? std::atoi(argv[1]) : 10000;
+  int nrounds = argc > 2 ? std::atoi(argv[2]) : 20;
+  int nthreads = libbirch::get_max_threads();
+  if (nthreads < 2) {
+    std::cerr << "skipped, requires at least two threads" << std::endl;
+    return 77;
+  }
+
+  std::vector<std::vector<Pointer>> objects(nthreads,
+      std::vector<Pointer>(nobjects));
+  int64_t bound = 2*int64_t(nthreads)*nobjects;
+  for (int r = 0; r < nrounds; ++r) {
+    #pragma omp parallel num_threads(nthreads)
+    {
+      int tid = libbirch::get_thread_num();
+      auto& mine = objects[tid];
+      for (int i = 0; i < nobjects; ++i) {
+        mine[i] = Pointer(new birch::type::Object());
+      }
+      #pragma omp barrier
+      auto& theirs = objects[(tid + 1) % nthreads];
+      for (int i = 0; i < nobjects; ++i) {
+        theirs[i].release();
+      }
+    }
+    auto nlive = birch::type::Object::nlive.load();
+    if (nlive > bound) {
+      std::cerr << "failed, " << nlive << " live objects after round " <<
+          (r + 1) << ", expected at most " << bound << std::endl;
+      return 1;
+    }
+  }
+
+  libbirch::collect();
+  libbirch::set_collect_threshold(nobjects, 0u);
+  std::vector<Pointer> last(nobjects);
+  #pragma omp parallel num_threads(2)
+  {
+    if (libbirch::get_thread_num() == 0) {
+      for (int i = 0; i < nobjects; ++i) {
+        last[i] = Pointer(new birch::type::Object());
+      }
+    }
+    #pragma omp barrier
+    if (libbirch::get_thread_num() == 1) {
+      for (int i = 0; i < nobjects; ++i) {
+        last[i].release();
+      }
+    }
+  }
+  libbirch::collect_if_due();
+  auto nlive = birch::type::Object::nlive.load();
+  if (nlive > 0) {
+    std::cerr << "failed, " << nlive << " live objects after automatic " <<
+        "collection, expected none" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file
+ *
+ * Test of the possible roots registered by the release of arrays of
+ * pointers that share a buffer. A buffer marked by a cycle collection while
+ * shared has each later release by one of its arrays register the referents
+ * of all elements as possible roots (see Buffer::isMarkedShared()). Once
+ * only one array uses the buffer again, this should stop, so that further
+ * copies and releases of that array, across repeated collections, register
+ * no possible roots, rather than a number proportional to its size each
+ * time.
+ *
+ * Usage:
+ *
+ *     test/roots [nelements] [nrounds]
+ *
+ * Exits with a nonzero status on failure.
+ */
+#include "libbirch/libbirch.hpp"
+
+#include <iostream>
+
+namespace birch {
+namespace type {
+/**
+ * Minimal class for the elements.
+ */
+class Object : public libbirch::Any {
+public:
+  using class_type_ = Object;
+  using this_type_ = Object;
+  using super_type_ = libbirch::Any;
+
+  LIBBIRCH_CLASS(Object, libbirch::Any)
+  LIBBIRCH_MEMBERS()
+};
+
+/**
+ * Class that holds an array of pointers.
+ */
+class Holder : public libbirch::Any {
+public:
+  using class_type_ = Holder;
+  using this_type_ = Holder;
+  using super_type_ = libbirch::Any;
+
+  libbirch::DefaultArray<libbirch::Lazy<libbirch::Shared<Object>>,1> xs;
+
+  LIBBIRCH_CLASS(Holder, libbirch::Any)
+  LIBBIRCH_MEMBERS(xs)
+};
+}
+}
+
+using Pointer = libbirch::Shared<birch::type::Holder>;
+
+int main(int argc, char** argv) {
+  int nelements = argc > 1 ? std::atoi(argv[1]) : 1000;
+  int nrounds = argc > 2 ? std::atoi(argv[2]) : 10;
+  libbirch::set_stats(true);
+
+  /* two holders share the buffer of the array; the first is made a possible
+   * root, so that the collection marks the buffer while shared */
+  Pointer a(new birch::type::Holder());
+  a->xs = libbirch::DefaultArray<libbirch::Lazy<libbirch::Shared<
+      birch::type::Object>>,1>(libbirch::make_shape(nelements));
+  Pointer b(new birch::type::Holder());
+  b->xs = a->xs;
+  Pointer a1(a);
+  a1.release();
+  libbirch::collect();
+
+  /* the release by the second holder must register the elements */
+  b.release();
+
+  for (int r = 0; r < nrounds; ++r) {
+    libbirch::reset_stats();
+    {
+      auto xs = a->xs;  // shares the buffer
+    }
+    Pointer a2(a);
+    a2.release();
+    libbirch::collect();
+    auto nroots = libbirch::stats().nroots;
+    if (nroots >= uint64_t(nelements)) {
+      std::cerr << "failed, " << nroots << " possible roots in round " <<
+          (r + 1) << ", expected fewer than " << nelements << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}